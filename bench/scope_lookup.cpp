@@ -0,0 +1,63 @@
+// scope lookup benchmark: random lookups in a Scope against the std::map
+// keyed by name that scopes used to be, for a few scope sizes
+//
+// build and run from the repository root:
+//   g++ -std=c++17 -O2 -Isrc bench/scope_lookup.cpp src/model/environment/*.cpp -o scope_lookup && ./scope_lookup
+
+#include "model/environment/Scope.h"
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr size_t LOOKUPS = 2000000;
+
+    double nanosPerLookup(std::chrono::steady_clock::duration elapsed) {
+        return std::chrono::duration<double, std::nano>(elapsed).count() / LOOKUPS;
+    }
+}
+
+int main() {
+    std::printf("variables   std::map   flat table\n");
+    for (size_t n : { 16, 256, 4096, 65536 }) {
+        std::vector<std::string> names;
+        std::vector<SymbolId> symbols;
+        for (size_t i = 0; i < n; ++i) {
+            names.push_back("var_" + std::to_string(i * 7919));
+            symbols.push_back(SymbolTable::intern(names.back()));
+        }
+
+        std::map<std::string, Variable> byName;
+        Scope scope;
+        for (size_t i = 0; i < n; ++i) {
+            byName.emplace(names[i], Variable{ Type::INT, Value(1) });
+            scope.declareVariable(symbols[i], Type::INT, Value(1));
+        }
+
+        // the same random order for both, fixed so runs are comparable
+        std::mt19937 rng(1);
+        std::vector<size_t> order(LOOKUPS);
+        for (size_t& index : order) {
+            index = rng() % n;
+        }
+
+        // summed so the lookups can't be optimized away
+        long sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t index : order) {
+            sum += byName.find(names[index])->second.value.as<int>();
+        }
+        auto mapped = std::chrono::steady_clock::now();
+        for (size_t index : order) {
+            sum += scope.findVariable(symbols[index])->value.as<int>();
+        }
+        auto flat = std::chrono::steady_clock::now();
+
+        std::printf("%9zu %8.1f ns %9.1f ns   (%ld)\n", n,
+            nanosPerLookup(mapped - start), nanosPerLookup(flat - mapped), sum);
+    }
+    return 0;
+}
@@ -1,12 +1,30 @@
 #include "ApplicationController.h"
+#include <chrono>
+
+namespace {
+    // how often an idle worker looks for finished background jobs
+    constexpr auto JOB_POLL_INTERVAL = std::chrono::milliseconds(50);
+}
 
 ApplicationController::ApplicationController() {
-    updatePrompt();
+    gui.setPrompt(">>> ");
+    worker = std::thread(&ApplicationController::run, this);
+}
+
+ApplicationController::~ApplicationController() {
+    stopping = true;
+    shell.interrupt();
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+    worker.join();
 }
 
 void ApplicationController::start() {
     while (gui.isWindowOpen()) {
         processEvents();
+        drainEvents();
         gui.update();
         gui.render();
     }
@@ -18,53 +36,120 @@ void ApplicationController::processEvents() {
         if (event.type == sf::Event::Closed) {
             gui.getWindow().close();
         }
+        else if (event.type == sf::Event::KeyPressed && event.key.control && event.key.code == sf::Keyboard::C) {
+            // stops whatever runs now and drops the lines typed so far
+            gui.addOutputLine(gui.getPrompt() + gui.getCurrentInput() + "^C");
+            gui.clearInput();
+            shell.interrupt();
+            submit({ Request::Kind::Cancel });
+        }
         else {
             gui.handleEvent(event);
             if (event.type == sf::Event::KeyPressed &&
                 event.key.code == sf::Keyboard::Return) {
                 std::string input = gui.getCurrentInput();
                 if (!input.empty()) {
-                    if (event.key.shift) {
-                        shell.appendInput(input);
-						shell.setMultiLine(true);
-						gui.addOutputLine(gui.getPrompt() + input);
-                        gui.clearInput();
-                    }
-                    else {
-                        handleInput(input);
-						shell.setMultiLine(false);
-                        gui.clearInput();
-                    }
+                    gui.addOutputLine(gui.getPrompt() + input);
+                    gui.clearInput();
+                    submit({ Request::Kind::Line, input, event.key.shift });
                 }
-                updatePrompt();
             }
         }
     }
 }
 
-void ApplicationController::handleInput(const std::string& input) {
-    if (input.empty()) {
-        return;
+void ApplicationController::submit(Request request) {
+    // the worker drains requests far faster than anyone types
+    while (!requests.push(std::move(request))) {
+        std::this_thread::yield();
+    }
+    {
+        // taken so the notify can't slip in between the worker's check and its wait
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+}
+
+// everything the worker produced since the last frame
+void ApplicationController::drainEvents() {
+    ShellEvent event;
+    while (events.pop(event)) {
+        if (event.kind == ShellEvent::Kind::Prompt) {
+            gui.setPrompt(event.text);
+        }
+        else {
+            addOutput(event.text);
+        }
+    }
+}
+
+// one output line per line of text
+void ApplicationController::addOutput(const std::string& text) {
+    size_t start = 0;
+    while (true) {
+        size_t end = text.find('\n', start);
+        gui.addOutputLine(text.substr(start, end - start));
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+}
+
+void ApplicationController::run() {
+    while (!stopping) {
+        Request request;
+        if (requests.pop(request)) {
+            handleRequest(request);
+            continue;
+        }
+        for (std::string& report : shell.pollJobs()) {
+            post(ShellEvent::Kind::Output, std::move(report));
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait_for(lock, JOB_POLL_INTERVAL, [this]() { return stopping || !requests.empty(); });
     }
+}
 
-    shell.appendInput(input);
+void ApplicationController::handleRequest(Request& request) {
+    if (request.kind == Request::Kind::Cancel) {
+        shell.clearBuffer();
+        shell.setMultiLine(false);
+        shell.clearInterrupt();
+        post(ShellEvent::Kind::Prompt, ">>> ");
+        return;
+    }
 
-    // show the final line that triggered evaluation
-    gui.addOutputLine(gui.getPrompt() + input);
+    shell.appendInput(request.line);
+    // keep collecting lines until every block is closed
+    if (request.continued || shell.needsMoreInput()) {
+        shell.setMultiLine(true);
+        post(ShellEvent::Kind::Prompt, "... ");
+        return;
+    }
 
     try {
         // evaluate and show result
         std::string result = shell.executeBuffer();
         if (!result.empty()) {
-            gui.addOutputLine("=> " + result);
+            post(ShellEvent::Kind::Output, "=> " + result);
         }
     }
     catch (const std::exception& e) {
-        gui.addOutputLine(std::string("Error: ") + e.what());
+        post(ShellEvent::Kind::Output, std::string("Error: ") + e.what());
         shell.clearBuffer();
     }
+    shell.setMultiLine(false);
+    post(ShellEvent::Kind::Prompt, ">>> ");
 }
 
-void ApplicationController::updatePrompt() {
-    gui.setPrompt(shell.isInMultiLine() ? "... " : ">>> ");
-}
\ No newline at end of file
+void ApplicationController::post(ShellEvent::Kind kind, std::string text) {
+    ShellEvent event{ kind, std::move(text) };
+    // the GUI drains every frame, a full queue only means it is behind
+    while (!events.push(std::move(event))) {
+        if (stopping) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
@@ -2,18 +2,52 @@
 
 #include "../view/ShellGUI.h"
 #include "ShellController.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
+// the GUI thread only draws and takes input; every input is evaluated on a
+// worker thread, which owns the shell and streams back what to show
 class ApplicationController {
 public:
     ApplicationController();
+    ~ApplicationController();
     void start();
 
 private:
+    // GUI thread -> worker
+    struct Request {
+        enum class Kind { Line, Cancel } kind = Kind::Line;
+        std::string line;
+        bool continued = false; // shift+return, more lines follow
+    };
+
+    // worker -> GUI thread
+    struct ShellEvent {
+        enum class Kind { Output, Prompt } kind = Kind::Output;
+        std::string text;
+    };
+
     ShellGUI gui;
-    ShellController shell;
+    ShellController shell; // only touched by the worker, apart from interrupt()
+
+    SpscQueue<Request, 256> requests;
+    SpscQueue<ShellEvent, 1024> events;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{ false };
+    std::thread worker;
 
-    void handleInput(const std::string& input);
-    void updatePrompt();
     void processEvents();
-};
\ No newline at end of file
+    void submit(Request request);
+    void drainEvents();
+    void addOutput(const std::string& text);
+
+    // worker side
+    void run();
+    void handleRequest(Request& request);
+    void post(ShellEvent::Kind kind, std::string text);
+};
@@ -1,4 +1,19 @@
 #include "ShellController.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+ShellController::~ShellController() {
+    for (auto& job : jobs) {
+        job->killed = true;
+    }
+    for (auto& job : jobs) {
+        if (job->thread.joinable()) {
+            job->thread.join();
+        }
+    }
+}
 
 void ShellController::appendInput(const std::string& input) {
     if (inputState.buf.empty()) {
@@ -7,24 +22,347 @@ void ShellController::appendInput(const std::string& input) {
     else {
         inputState.buf += "\n" + input;
     }
+    inputState.lines++;
+
+    // shell commands start with ':' on the first line and bypass the lexer
+    if (inputState.lines == 1) {
+        size_t start = input.find_first_not_of(" \t");
+        if (start != std::string::npos && input[start] == ':') {
+            inputState.command = input.substr(start);
+            return;
+        }
+    }
+    if (!inputState.command.empty() || !inputState.lexError.empty()) {
+        return; // already broken, executeBuffer reports it
+    }
+    if (inputState.background) {
+        if (input.find_first_not_of(" \t") != std::string::npos) {
+            inputState.lexError = "'&' has to end the input";
+        }
+        return;
+    }
+
+    // a trailing & sends the input to the background; a trailing && is kept,
+    // the lexer rejects it like any other &
+    std::string line = input;
+    size_t last = line.find_last_not_of(" \t");
+    if (last != std::string::npos && line[last] == '&' && (last == 0 || line[last - 1] != '&')) {
+        inputState.background = true;
+        line.erase(last);
+    }
+
+    // only the new line is lexed, earlier lines keep their tokens
+    try {
+        Lexer lexer(line, inputState.lines);
+        for (Token token = lexer.next(); token.type != TokenType::EndOfFile; token = lexer.next()) {
+            switch (token.type) {
+            case TokenType::LeftBrace:
+            case TokenType::LeftParen:
+            case TokenType::LeftBracket:
+                inputState.depth++;
+                break;
+            case TokenType::RightBrace:
+            case TokenType::RightParen:
+            case TokenType::RightBracket:
+                inputState.depth--;
+                break;
+            default:
+                break;
+            }
+            inputState.tokens.push_back(std::move(token));
+        }
+    }
+    catch (const LexError& e) {
+        inputState.lexError = e.what();
+    }
 }
 
 std::string ShellController::executeBuffer() {
+    if (!inputState.command.empty()) {
+        std::string command = inputState.command;
+        inputState.reset();
+        return runCommand(command);
+    }
+    if (inputState.background && inputState.lexError.empty()) {
+        std::string reply = startJob();
+        inputState.reset();
+        return reply;
+    }
+
+    // each input runs against a snapshot of the globals and either commits
+    // as a whole or leaves the environment as it was
+    globalEnv.beginTransaction();
     try {
-        std::unique_ptr<ASTNode> ast = parser.parse(inputState.buf);
-        if (!ast) {
-            throw std::runtime_error("Failed to parse input");
+        if (!inputState.lexError.empty()) {
+            throw std::runtime_error(inputState.lexError);
+        }
+
+        Value result;
+        if (std::shared_ptr<ParseCache::Program> program = parseCache.find(inputState.buf)) {
+            for (const auto& stmt : *program) {
+                result = interpreter.evaluate(*stmt);
+            }
+        }
+        else {
+            // run each top-level statement as soon as it is parsed, statements
+            // are only kept if the input is small enough to be cached
+            bool cacheable = inputState.buf.size() <= ParseCache::MAX_SOURCE_LENGTH;
+            auto parsed = std::make_shared<ParseCache::Program>();
+
+            parser.begin(std::move(inputState.tokens));
+            while (std::unique_ptr<ASTNode> stmt = parser.nextStatement()) {
+                result = interpreter.evaluate(*stmt);
+                if (cacheable) {
+                    parsed->push_back(std::move(stmt));
+                }
+            }
+            // what ran before the statement that failed to parse is rolled back
+            if (parser.stoppedEarly()) {
+                throw std::runtime_error(parser.errorMessage());
+            }
+            if (cacheable) {
+                parseCache.insert(inputState.buf, std::move(parsed));
+            }
         }
-        Value result = interpreter.evaluate(*ast);
+        globalEnv.commit();
+        interpreter.releaseTemporaries();
         inputState.reset();
         return result.toString();  // always return the string representation
     }
     catch (const std::bad_alloc& e) {
+        globalEnv.rollback();
+        interpreter.releaseTemporaries();
         inputState.reset();
         throw; // rethrow the bad_alloc
     }
     catch (const std::exception& e) {
+        globalEnv.rollback();
+        interpreter.releaseTemporaries();
         inputState.reset();
         return std::string("Error: ") + e.what();
     }
-}
\ No newline at end of file
+}
+
+std::string ShellController::runCommand(const std::string& command) {
+    // a command name, optionally followed by one argument
+    size_t nameEnd = command.find_first_of(" \t");
+    std::string name = command.substr(0, nameEnd);
+    std::string argument;
+    size_t start = nameEnd == std::string::npos ? nameEnd : command.find_first_not_of(" \t", nameEnd);
+    if (start != std::string::npos) {
+        argument = command.substr(start, command.find_last_not_of(" \t") - start + 1);
+    }
+
+    if (name == ":undo") {
+        return globalEnv.undo() ? "undone" : "Error: nothing to undo";
+    }
+    if (name == ":run") {
+        return argument.empty() ? "Error: usage :run <file>" : runScript(argument);
+    }
+    if (name == ":jobs") {
+        return listJobs();
+    }
+    if (name == ":wait") {
+        return waitJobs(argument);
+    }
+    if (name == ":kill") {
+        return killJob(argument);
+    }
+    return "Error: unknown command " + command;
+}
+
+std::string ShellController::runScript(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return "Error: can't open " + path;
+    }
+    std::stringstream source;
+    source << file.rdbuf();
+
+    // the whole script is one input: it commits or rolls back as a whole
+    globalEnv.beginTransaction();
+    try {
+        Value result;
+        std::vector<std::unique_ptr<ASTNode>> window;
+        parser.begin(source.str());
+        do {
+            window.clear();
+            while (window.size() < SCRIPT_WINDOW) {
+                std::unique_ptr<ASTNode> stmt = parser.nextStatement();
+                if (!stmt) {
+                    break;
+                }
+                window.push_back(std::move(stmt));
+            }
+            if (!window.empty()) {
+                result = interpreter.evaluateScript(window);
+            }
+        } while (window.size() == SCRIPT_WINDOW);
+        if (parser.stoppedEarly()) {
+            throw std::runtime_error(parser.errorMessage());
+        }
+
+        globalEnv.commit();
+        interpreter.releaseTemporaries();
+        return result.toString();
+    }
+    catch (const std::bad_alloc& e) {
+        globalEnv.rollback();
+        interpreter.releaseTemporaries();
+        throw;
+    }
+    catch (const std::exception& e) {
+        globalEnv.rollback();
+        interpreter.releaseTemporaries();
+        return std::string("Error: ") + e.what();
+    }
+}
+
+std::string ShellController::startJob() {
+    auto job = std::make_unique<Job>();
+    job->id = nextJobId++;
+    std::string& buf = inputState.buf;
+    job->source = buf.substr(0, std::min(buf.find('\n'), buf.find_last_of('&')));
+    job->source.erase(job->source.find_last_not_of(" \t") + 1);
+    job->started = std::chrono::steady_clock::now();
+    job->env = globalEnv.fork();
+
+    Job& started = *job;
+    jobs.push_back(std::move(job));
+    started.thread = std::thread(runJob, std::ref(started), std::move(inputState.tokens));
+    return "[" + std::to_string(started.id) + "] started";
+}
+
+void ShellController::runJob(Job& job, std::vector<Token> tokens) {
+    Parser parser;
+    Interpreter interpreter(*job.env);
+    interpreter.setInterruptFlag(&job.killed);
+
+    // the transaction records what the job changed, for merging it back
+    job.env->beginTransaction();
+    try {
+        Value result;
+        parser.begin(std::move(tokens));
+        while (std::unique_ptr<ASTNode> stmt = parser.nextStatement()) {
+            result = interpreter.evaluate(*stmt);
+            interpreter.releaseTemporaries();
+        }
+        if (parser.stoppedEarly()) {
+            throw std::runtime_error(parser.errorMessage());
+        }
+        job.result = result.toString();
+    }
+    catch (const std::exception& e) {
+        job.failed = true;
+        job.result = std::string("Error: ") + e.what();
+    }
+    job.finished.store(true, std::memory_order_release);
+}
+
+// joined job's report; a job that succeeded is merged as an input of its own,
+// so it can be undone, and its changes win over anything done meanwhile
+std::string ShellController::finishJob(Job& job) {
+    std::string tag = "[" + std::to_string(job.id) + "] ";
+    if (job.killed) {
+        return tag + "killed";
+    }
+    if (job.failed) {
+        return tag + job.result;
+    }
+    globalEnv.beginTransaction();
+    globalEnv.mergeChanges(*job.env);
+    globalEnv.commit();
+    return tag + "done => " + job.result;
+}
+
+std::vector<std::string> ShellController::pollJobs() {
+    std::vector<std::string> reports;
+    for (auto it = jobs.begin(); it != jobs.end();) {
+        Job& job = **it;
+        if (!job.finished.load(std::memory_order_acquire)) {
+            ++it;
+            continue;
+        }
+        if (job.thread.joinable()) {
+            job.thread.join();
+        }
+        reports.push_back(finishJob(job));
+        it = jobs.erase(it);
+    }
+    return reports;
+}
+
+ShellController::Job* ShellController::findJob(const std::string& id) {
+    for (auto& job : jobs) {
+        if (std::to_string(job->id) == id) {
+            return job.get();
+        }
+    }
+    return nullptr;
+}
+
+std::string ShellController::listJobs() const {
+    if (jobs.empty()) {
+        return "no jobs";
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::string list;
+    for (const auto& job : jobs) {
+        char elapsed[32];
+        std::snprintf(elapsed, sizeof(elapsed), "%.1fs",
+            std::chrono::duration<double>(now - job->started).count());
+        if (!list.empty()) {
+            list += "\n";
+        }
+        list += "[" + std::to_string(job->id) + "] " + (job->finished ? "done" : "running") + " " +
+            elapsed + "  " + job->source;
+    }
+    return list;
+}
+
+// blocks until the job, or every job without an id, is done
+std::string ShellController::waitJobs(const std::string& id) {
+    if (jobs.empty()) {
+        return "no jobs";
+    }
+    Job* awaited = nullptr;
+    if (!id.empty() && !(awaited = findJob(id))) {
+        return "Error: no job " + id;
+    }
+
+    // polled rather than joined so an interrupt can end the wait
+    auto done = [&]() {
+        if (awaited) {
+            return awaited->finished.load();
+        }
+        return std::all_of(jobs.begin(), jobs.end(), [](const auto& job) { return job->finished.load(); });
+    };
+    while (!done()) {
+        if (interrupted) {
+            return "Error: interrupted";
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::string reports;
+    for (const std::string& report : pollJobs()) {
+        if (!reports.empty()) {
+            reports += "\n";
+        }
+        reports += report;
+    }
+    return reports;
+}
+
+// jobs only stop at their next loop iteration or call
+std::string ShellController::killJob(const std::string& id) {
+    if (id.empty()) {
+        return "Error: usage :kill <job>";
+    }
+    Job* job = findJob(id);
+    if (!job) {
+        return "Error: no job " + id;
+    }
+    job->killed = true;
+    return "[" + id + "] stopping";
+}
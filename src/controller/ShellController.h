@@ -3,36 +3,99 @@
 
 #include "../model/environment/Environment.h"
 #include "../model/parser/Parser.h"
+#include "../model/parser/ParseCache.h"
 #include "../model/ast/Interpreter.h"
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 
 class ShellController {
 private:
+    // statements of a script parsed ahead of running them, the scheduler
+    // looks for independent statements within this window
+    static constexpr size_t SCRIPT_WINDOW = 256;
+
     Environment globalEnv;
     Interpreter interpreter;
     Parser parser;
+    ParseCache parseCache;
 
     struct InputState {
         std::string buf;
+        std::vector<Token> tokens; // lexed line by line as input is appended
+        int depth = 0;             // open braces, parens and brackets
+        int lines = 0;
+        std::string lexError;
+        std::string command;       // shell command such as :undo, not lexed
         bool inMultiLine = false;
+        bool background = false;   // the input ended with &
 
         void reset() {
             buf.clear();
+            command.clear();
+            tokens.clear();
+            depth = 0;
+            lines = 0;
+            lexError.clear();
             inMultiLine = false;
+            background = false;
         }
     } inputState;
 
+    // input running on a thread of its own against a fork of the globals,
+    // its changes are merged back once it is done
+    struct Job {
+        int id = 0;
+        std::string source; // first line of the input, for :jobs
+        std::chrono::steady_clock::time_point started;
+        std::unique_ptr<Environment> env;
+        std::atomic<bool> killed{ false };
+        std::atomic<bool> finished{ false };
+        std::string result; // written by the job before finished is set
+        bool failed = false;
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Job>> jobs;
+    int nextJobId = 1;
+    std::atomic<bool> interrupted{ false }; // Ctrl+C, stops the running input
+
 public:
-    ShellController() : interpreter(globalEnv) {}
+    ShellController() : interpreter(globalEnv) {
+        interpreter.setInterruptFlag(&interrupted);
+    }
+    ~ShellController();
 
     const Environment& getEnvironment() const { return globalEnv; }
+    const ParseCache& getParseCache() const { return parseCache; }
     bool isInMultiLine() const { return inputState.inMultiLine; }
 	void setMultiLine(bool multiLine) { inputState.inMultiLine = multiLine; }
     void clearBuffer() { inputState.reset(); }
+    // true while the buffered input still has unclosed braces, parens or brackets
+    bool needsMoreInput() const { return inputState.lexError.empty() && inputState.depth > 0; }
     std::string getBuffer() { return inputState.buf; }
 
     void appendInput(const std::string& input);
     std::string executeBuffer();
+    // safe to call from any thread: the running input, :run or :wait stops
+    // with an error at its next safepoint, and so does any input started
+    // before clearInterrupt()
+    void interrupt() { interrupted = true; }
+    void clearInterrupt() { interrupted = false; }
+    // merges every finished background job, one report line per job
+    std::vector<std::string> pollJobs();
+
+private:
+    std::string runCommand(const std::string& command);
+    std::string runScript(const std::string& path);
+
+    std::string startJob();
+    static void runJob(Job& job, std::vector<Token> tokens);
+    std::string finishJob(Job& job);
+    Job* findJob(const std::string& id);
+    std::string listJobs() const;
+    std::string waitJobs(const std::string& id);
+    std::string killJob(const std::string& id);
 };
 
 #endif //SEASHELL_SHELLCONTROLLER_H
\ No newline at end of file
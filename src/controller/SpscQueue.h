@@ -0,0 +1,50 @@
+#ifndef SEASHELL_SPSCQUEUE_H
+#define SEASHELL_SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// bounded lock-free queue between exactly one producer thread and one
+// consumer thread. Each side only writes its own index, the other index is
+// read with acquire, so neither ever blocks the other; the indices sit on
+// separate cache lines so the two sides don't contend for one
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // producer only; false if the queue is full, value is then left as it was
+    bool push(T&& value) {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots[tail & (Capacity - 1)] = std::move(value);
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only; false if the queue is empty
+    bool pop(T& value) {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots[head & (Capacity - 1)]);
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool empty() const {
+        return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head{ 0 }; // next slot to pop
+    alignas(64) std::atomic<size_t> tail{ 0 }; // next slot to push
+    std::array<T, Capacity> slots;
+};
+
+#endif //SEASHELL_SPSCQUEUE_H
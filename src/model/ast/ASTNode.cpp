@@ -33,6 +33,18 @@ std::string ArrayNode::toString() {
 	return result;
 }
 
+Value ArrayAllocNode::accept(ASTVisitor& visitor) {
+	return visitor.visit(*this);
+}
+
+std::string ArrayAllocNode::toString() {
+	std::string result = typeToString(elementType) + "[" + (size ? size->toString() : "") + "]";
+	if (initializer) {
+		result += " = " + initializer->toString();
+	}
+	return result;
+}
+
 Value ArrayAccessNode::accept(ASTVisitor& visitor) {
 	return visitor.visit(*this);
 }
@@ -98,6 +110,12 @@ bool AssignmentNode::isTypeCompatible(Type sourceType, Type targetType) {
 
 	if (targetType == Type::DOUBLE && sourceType == Type::INT) return true;
 
+	// a range is a read-only array until an element is written
+	if (targetType == Type::ARRAY && sourceType == Type::RANGE) return true;
+
+	// so is a struct array until it holds something other than its struct
+	if (targetType == Type::ARRAY && sourceType == Type::STRUCT_ARRAY) return true;
+
 	return false;
 }
 
@@ -156,18 +174,89 @@ std::string ForNode::toString() {
 	return forStr;
 }
 
+Value StructDeclNode::accept(ASTVisitor& visitor) {
+	return visitor.visit(*this);
+}
+
+std::string StructDeclNode::toString() {
+	std::string text = "struct " + SymbolTable::name(name) + " { ";
+	for (const auto& field : fields) {
+		text += typeToString(field.second) + " " + SymbolTable::name(field.first) + "; ";
+	}
+	return text + "}";
+}
+
+Value StructAllocNode::accept(ASTVisitor& visitor) {
+	return visitor.visit(*this);
+}
+
+std::string StructAllocNode::toString() {
+	std::string text = SymbolTable::name(structName);
+	if (array) {
+		text += "[" + (size ? size->toString() : "") + "]";
+	}
+	return initializer ? text + " = " + initializer->toString() : text;
+}
+
+size_t FieldSlotCache::slotOf(const StructLayout& layout, SymbolId field) {
+	uint64_t cached = entry.load(std::memory_order_relaxed);
+	if (cached >> 16 == layout.getId()) {
+		return static_cast<size_t>(cached & 0xFFFF);
+	}
+	int slot = layout.offsetOf(field);
+	if (slot < 0) {
+		throw std::runtime_error("struct " + SymbolTable::name(layout.getName()) + " has no field '" +
+			SymbolTable::name(field) + "'");
+	}
+	entry.store(layout.getId() << 16 | static_cast<uint64_t>(slot), std::memory_order_relaxed);
+	return static_cast<size_t>(slot);
+}
+
+Value FieldAccessNode::accept(ASTVisitor& visitor) {
+	return visitor.visit(*this);
+}
+
+Value FieldAssignmentNode::accept(ASTVisitor& visitor) {
+	return visitor.visit(*this);
+}
+
+Value ForEachNode::accept(ASTVisitor& visitor) {
+	return visitor.visit(*this);
+}
+
+std::string ForEachNode::toString() {
+	return "for (" + typeToString(elemType) + " " + SymbolTable::name(variable) + " : " +
+		sequence->toString() + ") " + body->toString();
+}
+
+Value ParallelForNode::accept(ASTVisitor& visitor) {
+	return visitor.visit(*this);
+}
+
+std::string ParallelForNode::toString() {
+	std::string text = "parallel";
+	if (!reductions.empty()) {
+		text += "(";
+		for (size_t i = 0; i < reductions.size(); ++i) {
+			text += (i ? ", " : "") + SymbolTable::name(reductions[i]);
+		}
+		text += ")";
+	}
+	return text + " " + loop->toString();
+}
+
 Value FunctionNode::accept(ASTVisitor& visitor) {
 	return visitor.visit(*this);
 }
 
 std::string FunctionNode::toString() {
 	std::stringstream ss;
-	ss << "function " << name << "(";
+	ss << "function " << getName() << "(";
 	for (size_t i = 0; i < parameters.size(); ++i) {
 		if (i > 0) ss << ", ";
-		ss << typeToString(parameters[i].second) << " " << parameters[i].first;
+		ss << typeToString(parameters[i].second) << " " << SymbolTable::name(parameters[i].first);
 	}
-	ss << ")" << typeToString(returnType) << " " << body->toString();
+	ss << ")" << typeToString(returnType) << " " << (body ? body->toString() : "{ ... }");
 	return ss.str();
 }
 
@@ -180,7 +269,7 @@ Value CallNode::accept(ASTVisitor& visitor) {
 }
 
 std::string CallNode::toString() {
-	std::string result = name + "(";
+	std::string result = getFuncName() + "(";
 	for (size_t i = 0; i < arguments.size(); ++i) {
 		if (i > 0) {
 			result += ", ";
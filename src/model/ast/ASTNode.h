@@ -5,8 +5,11 @@
 #include <string>
 #include <memory>
 #include <any>
+#include <atomic>
 
 #include "../environment/Value.h"
+#include "../environment/Symbol.h"
+#include "../parser/Token.h"
 
 class ASTVisitor;
 
@@ -37,7 +40,12 @@ public:
         Literal,
         Variable,
         Array,
+        ArrayAlloc,
         ArrayAccess,
+        StructDecl,
+        StructAlloc,
+        FieldAccess,
+        FieldAssignment,
         UnaryOp,
         BinaryOp,
         Assignment,
@@ -47,6 +55,8 @@ public:
         If,
         While,
         For,
+        ForEach,
+        ParallelFor,
         Return,
         Break,
         Continue,
@@ -56,7 +66,7 @@ public:
     virtual Value accept(ASTVisitor& visitor) = 0;
     virtual std::string toString() = 0;
     virtual NodeType getNodeType() const = 0;
-    //virtual ~ASTNode() = default;
+    virtual ~ASTNode() = default;
     virtual std::unique_ptr<ASTNode> clone() const = 0;
 };
 
@@ -105,6 +115,7 @@ public:
     explicit LiteralNode(double v) : value(v) {}
     explicit LiteralNode(bool v) : value(v) {}
     explicit LiteralNode(const std::string& v) : value(v) {}
+    explicit LiteralNode(Value v) : value(std::move(v)) {}
 
     Value accept(ASTVisitor& visitor) override;
 
@@ -126,14 +137,16 @@ public:
 
 class VariableNode : public ASTNode {
 private:
-    std::string name;
+    SymbolId symbol;
 public:
-    VariableNode(std::string name) : name(name) {};   
+    explicit VariableNode(SymbolId symbol) : symbol(symbol) {};
 
     Value accept(ASTVisitor& visitor) override;
 
+    SymbolId getSymbol() const { return symbol; }
+
     std::string toString() override {
-        return name;
+        return SymbolTable::name(symbol);
     }
     NodeType getNodeType() const override {
         return NodeType::Variable;
@@ -184,33 +197,78 @@ public:
     }
 };
 
+// sized array declaration, `int a[n];` or `int a[n] = {...};`
+class ArrayAllocNode : public ASTNode {
+private:
+    Type elementType;
+    std::unique_ptr<ASTNode> size;        // null when the initializer decides
+    std::unique_ptr<ASTNode> initializer; // null for default filled arrays
+
+public:
+    ArrayAllocNode(Type elemType, std::unique_ptr<ASTNode> size, std::unique_ptr<ASTNode> initializer)
+        : elementType(elemType), size(std::move(size)), initializer(std::move(initializer)) {
+    }
+
+    ArrayAllocNode(const ArrayAllocNode& other)
+        : elementType(other.elementType),
+        size(other.size ? other.size->clone() : nullptr),
+        initializer(other.initializer ? other.initializer->clone() : nullptr) {
+    }
+
+    Value accept(ASTVisitor& visitor) override;
+
+    std::string toString() override;
+
+    Type getElemType() const { return elementType; }
+    std::unique_ptr<ASTNode>& getSize() { return size; }
+    std::unique_ptr<ASTNode>& getInitializer() { return initializer; }
+
+    NodeType getNodeType() const override {
+        return NodeType::ArrayAlloc;
+    }
+
+    std::unique_ptr<ASTNode> clone() const override {
+        return std::make_unique<ArrayAllocNode>(*this);
+    }
+};
+
 class ArrayAccessNode : public ASTNode {
 private:
-    std::string arrayName;
+    SymbolId arraySymbol;
     std::unique_ptr<ASTNode> index;
+    std::unique_ptr<ASTNode> column; // second index of m[i][j], matrices only
 
 public:
-    ArrayAccessNode(std::string arrayName, std::unique_ptr<ASTNode> index)
-        : arrayName(arrayName), index(std::move(index)) {
+    ArrayAccessNode(SymbolId arraySymbol, std::unique_ptr<ASTNode> index, std::unique_ptr<ASTNode> column = nullptr)
+        : arraySymbol(arraySymbol), index(std::move(index)), column(std::move(column)) {
     }
 
     ArrayAccessNode(const ArrayAccessNode& other)
-        : arrayName(other.arrayName),
-        index(other.index->clone()) {
+        : arraySymbol(other.arraySymbol),
+        index(other.index->clone()),
+        column(other.column ? other.column->clone() : nullptr) {
     }
 
     Value accept(ASTVisitor& visitor) override;
 
+    SymbolId getSymbol() const {
+        return arraySymbol;
+    }
+
     std::string getName() {
-        return arrayName;
+        return SymbolTable::name(arraySymbol);
     }
 
     std::unique_ptr<ASTNode>& getIndex() {
         return index;
     }
 
+    std::unique_ptr<ASTNode>& getColumn() {
+        return column;
+    }
+
     std::string toString() override {
-        return arrayName + "[" + index->toString() + "]";
+        return getName() + "[" + index->toString() + "]" + (column ? "[" + column->toString() + "]" : "");
     }
 
     NodeType getNodeType() const override {
@@ -222,6 +280,157 @@ public:
     }
 };
 
+// struct Name { type field; ... }
+class StructDeclNode : public ASTNode {
+private:
+    SymbolId name;
+    std::vector<std::pair<SymbolId, Type>> fields;
+
+public:
+    StructDeclNode(SymbolId name, std::vector<std::pair<SymbolId, Type>> fields)
+        : name(name), fields(std::move(fields)) {
+    }
+
+    Value accept(ASTVisitor& visitor) override;
+    std::string toString() override;
+
+    SymbolId getSymbol() const { return name; }
+    const std::vector<std::pair<SymbolId, Type>>& getFields() const { return fields; }
+
+    NodeType getNodeType() const override {
+        return NodeType::StructDecl;
+    }
+
+    std::unique_ptr<ASTNode> clone() const override {
+        return std::make_unique<StructDeclNode>(*this);
+    }
+};
+
+// value of a struct variable declaration, `Point p;`, `Point p = q;` or `Point ps[n];`
+class StructAllocNode : public ASTNode {
+private:
+    SymbolId structName;
+    bool array;
+    std::unique_ptr<ASTNode> size;        // null when the initializer decides
+    std::unique_ptr<ASTNode> initializer; // null for default filled values
+
+public:
+    StructAllocNode(SymbolId structName, bool array, std::unique_ptr<ASTNode> size, std::unique_ptr<ASTNode> initializer)
+        : structName(structName), array(array), size(std::move(size)), initializer(std::move(initializer)) {
+    }
+
+    StructAllocNode(const StructAllocNode& other)
+        : structName(other.structName), array(other.array),
+        size(other.size ? other.size->clone() : nullptr),
+        initializer(other.initializer ? other.initializer->clone() : nullptr) {
+    }
+
+    Value accept(ASTVisitor& visitor) override;
+    std::string toString() override;
+
+    SymbolId getStructName() const { return structName; }
+    bool isArray() const { return array; }
+    std::unique_ptr<ASTNode>& getSize() { return size; }
+    std::unique_ptr<ASTNode>& getInitializer() { return initializer; }
+
+    NodeType getNodeType() const override {
+        return NodeType::StructAlloc;
+    }
+
+    std::unique_ptr<ASTNode> clone() const override {
+        return std::make_unique<StructAllocNode>(*this);
+    }
+};
+
+// remembers where a field sits in the last layout it was looked up in. The
+// parser can't know the layout, a variable's struct type is only known at
+// runtime, but a given access almost always sees the same one
+class FieldSlotCache {
+public:
+    FieldSlotCache() = default;
+    FieldSlotCache(const FieldSlotCache& other) : entry(other.entry.load(std::memory_order_relaxed)) {}
+
+    // slot of field in layout, throws if the struct has no such field
+    size_t slotOf(const StructLayout& layout, SymbolId field);
+
+private:
+    // layout id in the high bits, slot in the low 16
+    std::atomic<uint64_t> entry{ 0 };
+};
+
+// p.x or ps[i].x
+class FieldAccessNode : public ASTNode {
+private:
+    std::unique_ptr<ASTNode> object;
+    SymbolId field;
+    FieldSlotCache slot;
+
+public:
+    FieldAccessNode(std::unique_ptr<ASTNode> object, SymbolId field)
+        : object(std::move(object)), field(field) {
+    }
+
+    FieldAccessNode(const FieldAccessNode& other)
+        : object(other.object->clone()), field(other.field), slot(other.slot) {
+    }
+
+    Value accept(ASTVisitor& visitor) override;
+
+    std::unique_ptr<ASTNode>& getObject() { return object; }
+    SymbolId getField() const { return field; }
+    size_t slotIn(const StructLayout& layout) { return slot.slotOf(layout, field); }
+
+    std::string toString() override {
+        return object->toString() + "." + SymbolTable::name(field);
+    }
+
+    NodeType getNodeType() const override {
+        return NodeType::FieldAccess;
+    }
+
+    std::unique_ptr<ASTNode> clone() const override {
+        return std::make_unique<FieldAccessNode>(*this);
+    }
+};
+
+// p.x = ... or ps[i].x = ...
+class FieldAssignmentNode : public ASTNode {
+private:
+    std::unique_ptr<ASTNode> object; // variable or array access
+    SymbolId field;
+    std::unique_ptr<ASTNode> expression;
+    FieldSlotCache slot;
+
+public:
+    FieldAssignmentNode(std::unique_ptr<ASTNode> object, SymbolId field, std::unique_ptr<ASTNode> expression)
+        : object(std::move(object)), field(field), expression(std::move(expression)) {
+    }
+
+    FieldAssignmentNode(const FieldAssignmentNode& other)
+        : object(other.object->clone()), field(other.field),
+        expression(other.expression->clone()), slot(other.slot) {
+    }
+
+    Value accept(ASTVisitor& visitor) override;
+
+    std::unique_ptr<ASTNode>& getObject() { return object; }
+    SymbolId getField() const { return field; }
+    std::unique_ptr<ASTNode>& getExpression() { return expression; }
+    size_t slotIn(const StructLayout& layout) { return slot.slotOf(layout, field); }
+
+    std::string toString() override {
+        return object->toString() + "." + SymbolTable::name(field) + " = " + expression->toString();
+    }
+
+    NodeType getNodeType() const override {
+        return NodeType::FieldAssignment;
+    }
+
+    std::unique_ptr<ASTNode> clone() const override {
+        return std::make_unique<FieldAssignmentNode>(*this);
+    }
+};
+
 class UnaryOpNode : public ASTNode {
 private:
     Operator op;
@@ -290,26 +499,31 @@ public:
 
 class AssignmentNode : public ASTNode {
 private:
-    std::string variableName;
+    SymbolId variable;
     std::unique_ptr<ASTNode> index; // for array access
+    std::unique_ptr<ASTNode> column; // for m[i][j] = ...
     std::unique_ptr<ASTNode> expression;
     Type declaredType;
 
 public:
     // constructor for variable declaration
-    AssignmentNode(std::string varName, Type type, std::unique_ptr<ASTNode> expr)
-        : variableName(varName), expression(std::move(expr)), declaredType(type), index(nullptr) {};
+    AssignmentNode(SymbolId variable, Type type, std::unique_ptr<ASTNode> expr)
+        : variable(variable), expression(std::move(expr)), declaredType(type), index(nullptr) {};
 
     // constructor for assignment to existing variable
-    AssignmentNode(std::string varName, std::unique_ptr<ASTNode> expr)
-        : variableName(varName), expression(std::move(expr)), declaredType(Type::VOID), index(nullptr) {};
+    AssignmentNode(SymbolId variable, std::unique_ptr<ASTNode> expr)
+        : variable(variable), expression(std::move(expr)), declaredType(Type::VOID), index(nullptr) {};
 
 	// constructor for array element assignment
-    AssignmentNode(std::string arrayName, std::unique_ptr<ASTNode> expr, std::unique_ptr<ASTNode> index)
-        : variableName(arrayName), index(std::move(index)), expression(std::move(expr)), declaredType(Type::VOID) {};
+    AssignmentNode(SymbolId array, std::unique_ptr<ASTNode> expr, std::unique_ptr<ASTNode> index,
+        std::unique_ptr<ASTNode> column = nullptr)
+        : variable(array), index(std::move(index)), column(std::move(column)), expression(std::move(expr)),
+        declaredType(Type::VOID) {};
 
     AssignmentNode(const AssignmentNode& other)
-        : variableName(other.variableName),
+        : variable(other.variable),
+        index(other.index ? other.index->clone() : nullptr),
+        column(other.column ? other.column->clone() : nullptr),
         expression(other.expression->clone()),
         declaredType(other.declaredType) {
     }
@@ -318,15 +532,19 @@ public:
     static bool isTypeCompatible(Type sourceType, Type targetType);
 
     std::string toString() override {
-        return variableName + " = " + expression->toString();
+        return getVarName() + " = " + expression->toString();
     }
 
     NodeType getNodeType() const override {
         return NodeType::Assignment;
     }
 
+    SymbolId getSymbol() const {
+        return variable;
+    }
+
     std::string getVarName() {
-        return variableName;
+        return SymbolTable::name(variable);
     }
 
     std::unique_ptr<ASTNode>& getExpression() {
@@ -337,6 +555,10 @@ public:
         return index;
     }
 
+    std::unique_ptr<ASTNode>& getColumn() {
+        return column;
+    }
+
     Type getDeclType() {
         return declaredType;
     }
@@ -481,9 +703,9 @@ public:
     };
 
     ForNode(const ForNode& other)
-        : initialization(other.initialization->clone()),
-        condition(other.condition->clone()),
-        increment(other.increment->clone()),
+        : initialization(other.initialization ? other.initialization->clone() : nullptr),
+        condition(other.condition ? other.condition->clone() : nullptr),
+        increment(other.increment ? other.increment->clone() : nullptr),
         body(other.body->clone()) {
     }
 
@@ -515,37 +737,124 @@ public:
     }
 };
 
+// for (type name : sequence) body, over an array or range; name is bound to
+// a copy of each element in turn
+class ForEachNode : public ASTNode {
+private:
+    Type elemType;
+    SymbolId variable;
+    std::unique_ptr<ASTNode> sequence;
+    std::unique_ptr<ASTNode> body;
+
+public:
+    ForEachNode(Type elemType, SymbolId variable, std::unique_ptr<ASTNode> sequence, std::unique_ptr<ASTNode> body)
+        : elemType(elemType), variable(variable), sequence(std::move(sequence)), body(std::move(body)) {
+    }
+
+    ForEachNode(const ForEachNode& other)
+        : elemType(other.elemType), variable(other.variable),
+        sequence(other.sequence->clone()), body(other.body->clone()) {
+    }
+
+    Value accept(ASTVisitor& visitor) override;
+    std::string toString() override;
+
+    Type getElemType() const { return elemType; }
+    SymbolId getSymbol() const { return variable; }
+    std::unique_ptr<ASTNode>& getSequence() { return sequence; }
+    std::unique_ptr<ASTNode>& getBody() { return body; }
+
+    NodeType getNodeType() const override {
+        return NodeType::ForEach;
+    }
+
+    std::unique_ptr<ASTNode> clone() const override {
+        return std::make_unique<ForEachNode>(*this);
+    }
+};
+
+// parallel(s, ...) for (int i = a; i < b; i++) body, iterations run
+// concurrently and s, ... are summed over all of them
+class ParallelForNode : public ASTNode {
+private:
+    std::unique_ptr<ASTNode> loop; // a ForNode
+    std::vector<SymbolId> reductions;
+
+public:
+    ParallelForNode(std::unique_ptr<ASTNode> loop, std::vector<SymbolId> reductions)
+        : loop(std::move(loop)), reductions(std::move(reductions)) {
+    }
+
+    ParallelForNode(const ParallelForNode& other)
+        : loop(other.loop->clone()), reductions(other.reductions) {
+    }
+
+    Value accept(ASTVisitor& visitor) override;
+    std::string toString() override;
+
+    ForNode& getLoop() { return static_cast<ForNode&>(*loop); }
+    const std::vector<SymbolId>& getReductions() const { return reductions; }
+
+    NodeType getNodeType() const override {
+        return NodeType::ParallelFor;
+    }
+
+    std::unique_ptr<ASTNode> clone() const override {
+        return std::make_unique<ParallelForNode>(*this);
+    }
+};
+
 class FunctionNode : public ASTNode {
 private:
-    std::string name;
-    std::vector<std::pair<std::string, Type>> parameters;
+    SymbolId name;
+    std::vector<std::pair<SymbolId, Type>> parameters;
     Type returnType;
     std::unique_ptr<ASTNode> body;
+    std::vector<Token> deferredBody; // raw body tokens until the first call parses them
 public:
-    FunctionNode(const std::string& name,
-        std::vector<std::pair<std::string, Type>> parameters,
+    FunctionNode(SymbolId name,
+        std::vector<std::pair<SymbolId, Type>> parameters,
         Type returnType,
         std::unique_ptr<ASTNode> body)
         : name(name), parameters(std::move(parameters)), returnType(returnType), body(std::move(body)) {
     }
 
+    // constructor for a pre-parsed function whose body is parsed on first call
+    FunctionNode(SymbolId name,
+        std::vector<std::pair<SymbolId, Type>> parameters,
+        Type returnType,
+        std::vector<Token> deferredBody)
+        : name(name), parameters(std::move(parameters)), returnType(returnType), deferredBody(std::move(deferredBody)) {
+    }
+
     FunctionNode(const FunctionNode& other)
         : name(other.name),
         parameters(other.parameters),
         returnType(other.returnType),
-        body(other.body ? other.body->clone() : nullptr) {
+        body(other.body ? other.body->clone() : nullptr),
+        deferredBody(other.deferredBody) {
     }
 
     Value accept(ASTVisitor& visitor) override;
 
     std::string toString() override;
 
-    const std::string& getName() const { return name; }
+    SymbolId getSymbol() const { return name; }
+    const std::string& getName() const { return SymbolTable::name(name); }
     Type getReturnType() const { return returnType; }
-    const std::vector<std::pair<std::string, Type>>& getParameters() const { return parameters; }
+    const std::vector<std::pair<SymbolId, Type>>& getParameters() const { return parameters; }
 
     std::unique_ptr<ASTNode>& getBody() { return body; }
 
+    bool hasDeferredBody() const { return !body && !deferredBody.empty(); }
+    const std::vector<Token>& getDeferredBody() const { return deferredBody; }
+
+    void setBody(std::unique_ptr<ASTNode> parsedBody) {
+        body = std::move(parsedBody);
+        deferredBody.clear();
+        deferredBody.shrink_to_fit();
+    }
+
     NodeType getNodeType() const override {
         return NodeType::Function;
     }
@@ -562,7 +871,7 @@ public:
     ReturnNode(std::unique_ptr<ASTNode> expr) : expression(std::move(expr)) {}
 
     ReturnNode(const ReturnNode& other)
-        : expression(other.expression->clone()) {
+        : expression(other.expression ? other.expression->clone() : nullptr) {
     }
 
     Value accept(ASTVisitor& visitor) override;
@@ -584,10 +893,10 @@ public:
 
 class CallNode : public ASTNode {
 private:
-    std::string name;
+    SymbolId name;
     std::vector<std::unique_ptr<ASTNode>> arguments;
 public:
-    CallNode(const std::string& name, std::vector<std::unique_ptr<ASTNode>> args)
+    CallNode(SymbolId name, std::vector<std::unique_ptr<ASTNode>> args)
         : name(name), arguments(std::move(args)) {
     }
 
@@ -601,7 +910,8 @@ public:
 
     Value accept(ASTVisitor& visitor) override;
 
-    const std::string& getFuncName() const { return name; }
+    SymbolId getSymbol() const { return name; }
+    const std::string& getFuncName() const { return SymbolTable::name(name); }
     const std::vector<std::unique_ptr<ASTNode>>& getArguments() const { return arguments; }
 
     NodeType getNodeType() const override { return NodeType::FunctionCall; }
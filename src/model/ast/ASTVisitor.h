@@ -12,7 +12,12 @@ public:
     virtual Value visit(LiteralNode& node) = 0;
     virtual Value visit(VariableNode& node) = 0;
     virtual Value visit(ArrayNode& node) = 0;
+    virtual Value visit(ArrayAllocNode& node) = 0;
     virtual Value visit(ArrayAccessNode& node) = 0;
+    virtual Value visit(StructDeclNode& node) = 0;
+    virtual Value visit(StructAllocNode& node) = 0;
+    virtual Value visit(FieldAccessNode& node) = 0;
+    virtual Value visit(FieldAssignmentNode& node) = 0;
     virtual Value visit(UnaryOpNode& node) = 0;
     virtual Value visit(BinOpNode& node) = 0;
     virtual Value visit(AssignmentNode& node) = 0;
@@ -20,6 +25,8 @@ public:
     virtual Value visit(IfNode& node) = 0;
     virtual Value visit(WhileNode& node) = 0;
     virtual Value visit(ForNode& node) = 0;
+    virtual Value visit(ForEachNode& node) = 0;
+    virtual Value visit(ParallelForNode& node) = 0;
     virtual Value visit(FunctionNode& node) = 0;
     virtual Value visit(ReturnNode& node) = 0;
     virtual Value visit(CallNode& node) = 0;
@@ -0,0 +1,151 @@
+#include "ArrayArithmetic.h"
+#include "../kernels/ElementWise.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    ElementOp toElementOp(Operator op) {
+        switch (op) {
+        case Operator::Add: return ElementOp::Add;
+        case Operator::Subtract: return ElementOp::Subtract;
+        case Operator::Multiply: return ElementOp::Multiply;
+        case Operator::Divide: return ElementOp::Divide;
+        case Operator::Equal: return ElementOp::Equal;
+        case Operator::NotEqual: return ElementOp::NotEqual;
+        case Operator::Less: return ElementOp::Less;
+        case Operator::LessEqual: return ElementOp::LessEqual;
+        case Operator::Greater: return ElementOp::Greater;
+        case Operator::GreaterEqual: return ElementOp::GreaterEqual;
+        default: throw std::runtime_error("operation not supported for arrays");
+        }
+    }
+
+    template<typename T>
+    T number(const Value& value) {
+        return value.getType() == Type::INT ? static_cast<T>(value.as<int>()) : static_cast<T>(value.as<double>());
+    }
+
+    // copies the operand into one contiguous buffer the kernels can stream over
+    template<typename T>
+    Operand<T> pack(const Value& operand, std::pmr::vector<T>& storage) {
+        if (!operand.isSequence()) {
+            storage.push_back(number<T>(operand));
+            return { storage.data(), true };
+        }
+        storage.resize(operand.length());
+        if (operand.getType() == Type::RANGE) {
+            const Range& range = operand.as<Range>();
+            for (size_t i = 0; i < storage.size(); ++i) {
+                storage[i] = static_cast<T>(range.at(i));
+            }
+        }
+        else {
+            const auto& elements = operand.as<std::vector<Value>>();
+            for (size_t i = 0; i < storage.size(); ++i) {
+                storage[i] = number<T>(elements[i]);
+            }
+        }
+        return { storage.data(), false };
+    }
+
+    template<typename T>
+    void checkDivisors(const std::pmr::vector<T>& divisors) {
+        for (T divisor : divisors) {
+            if constexpr (std::is_same_v<T, int>) {
+                if (divisor == 0)
+                    throw std::runtime_error("cant divide by zero");
+            }
+            else {
+                if (std::abs(divisor) < std::numeric_limits<double>::epsilon())
+                    throw std::runtime_error("cant divide by zero.zero");
+            }
+        }
+    }
+
+    template<typename T>
+    Value compute(const Value& left, const Value& right, ElementOp op, size_t n, ScratchArena& scratch) {
+        std::pmr::vector<T> leftData(&scratch);
+        std::pmr::vector<T> rightData(&scratch);
+        Operand<T> a = pack(left, leftData);
+        Operand<T> b = pack(right, rightData);
+
+        std::vector<Value> result;
+        result.reserve(n);
+        if (isComparison(op)) {
+            std::pmr::vector<uint8_t> out(n, &scratch);
+            compareElementWise(op, a, b, out.data(), n);
+            for (uint8_t flag : out) {
+                result.emplace_back(flag != 0);
+            }
+        }
+        else {
+            if (op == ElementOp::Divide) {
+                checkDivisors(rightData);
+            }
+            std::pmr::vector<T> out(n, &scratch);
+            applyElementWise(op, a, b, out.data(), n);
+            for (T element : out) {
+                result.emplace_back(element);
+            }
+        }
+        return { std::move(result) };
+    }
+}
+
+bool hasOnlyInts(const Value& operand) {
+    switch (operand.getType()) {
+    case Type::INT:
+    case Type::RANGE:
+        return true;
+    case Type::DOUBLE:
+        return false;
+    case Type::ARRAY: {
+        bool ints = true;
+        for (const Value& element : operand.as<std::vector<Value>>()) {
+            Type type = element.getType();
+            if (type == Type::DOUBLE) {
+                ints = false;
+            }
+            else if (type != Type::INT) {
+                throw std::runtime_error("element-wise operations need numeric arrays, found " + typeToString(type));
+            }
+        }
+        return ints;
+    }
+    default:
+        throw std::runtime_error("invalid operand type for array operation: " + typeToString(operand.getType()));
+    }
+}
+
+void packNumbers(const Value& sequence, std::pmr::vector<int>& storage) {
+    pack(sequence, storage);
+}
+
+void packNumbers(const Value& sequence, std::pmr::vector<double>& storage) {
+    pack(sequence, storage);
+}
+
+Value elementWise(const Value& left, const Value& right, Operator op, ScratchArena& scratch) {
+    ElementOp elementOp = toElementOp(op);
+
+    size_t n;
+    if (left.isSequence() && right.isSequence()) {
+        n = left.length();
+        if (right.length() != n) {
+            throw std::runtime_error("array length mismatch: " + std::to_string(n) + " and " + std::to_string(right.length()));
+        }
+    }
+    else {
+        n = left.isSequence() ? left.length() : right.length();
+    }
+
+    // the packed copies only live for this operation
+    ScratchArena::Frame frame(scratch);
+    bool ints = hasOnlyInts(left);
+    ints = hasOnlyInts(right) && ints;
+    if (ints) {
+        return compute<int>(left, right, elementOp, n, scratch);
+    }
+    return compute<double>(left, right, elementOp, n, scratch);
+}
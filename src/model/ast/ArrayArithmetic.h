@@ -0,0 +1,17 @@
+#pragma once
+
+#include "ASTNode.h"
+#include "../environment/ScratchArena.h"
+
+// left op right where at least one side is an array or range and the other
+// is either a sequence of the same length or a number broadcast to every
+// element; arithmetic yields a new array, comparisons an array of bools
+Value elementWise(const Value& left, const Value& right, Operator op, ScratchArena& scratch);
+
+// true if a number, array or range holds only ints, false if it also has
+// doubles; throws for anything that is not numeric
+bool hasOnlyInts(const Value& operand);
+
+// copies the elements of a numeric array or range into one contiguous buffer
+void packNumbers(const Value& sequence, std::pmr::vector<int>& storage);
+void packNumbers(const Value& sequence, std::pmr::vector<double>& storage);
@@ -0,0 +1,617 @@
+#include "Builtins.h"
+#include "ArrayArithmetic.h"
+#include "Interpreter.h"
+#include "../environment/HashMap.h"
+#include "../kernels/MatrixKernels.h"
+#include "../kernels/Reduce.h"
+#include "../kernels/Sort.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    // arguments were checked against the signature before any builtin runs
+    const SharedString& stringArgument(const BuiltinArgs& args, size_t index) {
+        return args[index]->as<SharedString>();
+    }
+
+    int intArgument(const BuiltinArgs& args, size_t index) {
+        return args[index]->as<int>();
+    }
+
+    // substr(s, start) or substr(s, start, length), shares s's buffer
+    Value substr(Interpreter&, const BuiltinArgs& args) {
+        const SharedString& text = stringArgument(args, 0);
+        int start = intArgument(args, 1);
+        int count = args.size() > 2 ? intArgument(args, 2) : static_cast<int>(text.size());
+        if (start < 0 || static_cast<size_t>(start) > text.size()) {
+            throw std::runtime_error("substr: start " + std::to_string(start) + " out of range");
+        }
+        if (count < 0) {
+            throw std::runtime_error("substr: negative length");
+        }
+        return text.substr(start, count);
+    }
+
+    // find(s, needle) or find(s, needle, from), -1 if absent
+    Value find(Interpreter&, const BuiltinArgs& args) {
+        const SharedString& text = stringArgument(args, 0);
+        const SharedString& needle = stringArgument(args, 1);
+        int from = args.size() > 2 ? intArgument(args, 2) : 0;
+        if (from < 0) {
+            throw std::runtime_error("find: negative start");
+        }
+        size_t pos = text.find(needle.view(), from);
+        return pos == SharedString::npos ? -1 : static_cast<int>(pos);
+    }
+
+    // split(s, separator), the pieces are slices of s
+    Value split(Interpreter&, const BuiltinArgs& args) {
+        const SharedString& text = stringArgument(args, 0);
+        const SharedString& separator = stringArgument(args, 1);
+        if (separator.empty()) {
+            throw std::runtime_error("split: empty separator");
+        }
+        std::vector<Value> pieces;
+        size_t start = 0;
+        for (size_t pos; (pos = text.find(separator.view(), start)) != SharedString::npos;
+             start = pos + separator.size()) {
+            pieces.emplace_back(text.substr(start, pos - start));
+        }
+        pieces.emplace_back(text.substr(start));
+        return { std::move(pieces) };
+    }
+
+    Value startsWith(Interpreter&, const BuiltinArgs& args) {
+        const SharedString& text = stringArgument(args, 0);
+        return text.startsWith(stringArgument(args, 1).view());
+    }
+
+    // range(end), range(start, end) or range(start, end, step)
+    Value range(Interpreter&, const BuiltinArgs& args) {
+        if (args.size() == 1) {
+            return Range{ 0, intArgument(args, 0), 1 };
+        }
+        int step = args.size() > 2 ? intArgument(args, 2) : 1;
+        if (step == 0) {
+            throw std::runtime_error("range: step must not be zero");
+        }
+        return Range{ intArgument(args, 0), intArgument(args, 1), step };
+    }
+
+    Value len(Interpreter&, const BuiltinArgs& args) {
+        const Value& value = *args[0];
+        if (value.getType() == Type::STRING) {
+            return static_cast<int>(value.as<SharedString>().size());
+        }
+        if (value.getType() == Type::MAP) {
+            return static_cast<int>(value.as<Map>().size());
+        }
+        return static_cast<int>(value.length());
+    }
+
+    Value has(Interpreter&, const BuiltinArgs& args) {
+        const Map& map = args[0]->as<Map>();
+        HashMap::checkKey(*args[1]);
+        return map.read().find(*args[1]) != nullptr;
+    }
+
+    // remove(m, key), true if key was present
+    Value remove(Interpreter&, const BuiltinArgs& args) {
+        HashMap::checkKey(*args[1]);
+        if (!args[0]->as<Map>().read().find(*args[1])) {
+            return false; // don't unshare the table for nothing
+        }
+        return args[0]->mapForWrite().erase(*args[1]);
+    }
+
+    Value keys(Interpreter&, const BuiltinArgs& args) {
+        return mapKeys(args[0]->as<Map>().read());
+    }
+
+    const Value& nonEmptySequence(const BuiltinArgs& args, size_t index, const char* function) {
+        const Value& value = *args[index];
+        if (value.length() == 0) {
+            throw std::runtime_error(std::string(function) + " of an empty array");
+        }
+        return value;
+    }
+
+    Value intResult(int64_t result, const char* function) {
+        if (result < std::numeric_limits<int>::min() || result > std::numeric_limits<int>::max()) {
+            throw std::runtime_error(std::string(function) + ": result overflows int");
+        }
+        return static_cast<int>(result);
+    }
+
+    // closed form, a range is never expanded to be summed
+    int64_t rangeSum(const Range& range) {
+        int64_t n = static_cast<int64_t>(range.size());
+        int64_t pairs = n % 2 == 0 ? n / 2 * (n - 1) : (n - 1) / 2 * n; // n * (n - 1) / 2
+        return n * range.start + pairs * range.step;
+    }
+
+    template<typename T>
+    std::pmr::vector<T> packed(Interpreter& interpreter, const Value& sequence) {
+        std::pmr::vector<T> data(&interpreter.getScratch());
+        packNumbers(sequence, data);
+        return data;
+    }
+
+    Value sum(Interpreter& interpreter, const BuiltinArgs& args) {
+        const Value& values = *args[0];
+        if (values.getType() == Type::RANGE) {
+            return intResult(rangeSum(values.as<Range>()), "sum");
+        }
+        ScratchArena::Frame frame(interpreter.getScratch());
+        if (hasOnlyInts(values)) {
+            auto data = packed<int>(interpreter, values);
+            return intResult(sumOf(data.data(), data.size()), "sum");
+        }
+        auto data = packed<double>(interpreter, values);
+        return sumOf(data.data(), data.size());
+    }
+
+    Value mean(Interpreter& interpreter, const BuiltinArgs& args) {
+        const Value& values = nonEmptySequence(args, 0, "mean");
+        double n = static_cast<double>(values.length());
+        if (values.getType() == Type::RANGE) {
+            return static_cast<double>(rangeSum(values.as<Range>())) / n;
+        }
+        ScratchArena::Frame frame(interpreter.getScratch());
+        if (hasOnlyInts(values)) {
+            auto data = packed<int>(interpreter, values);
+            return static_cast<double>(sumOf(data.data(), data.size())) / n;
+        }
+        auto data = packed<double>(interpreter, values);
+        return sumOf(data.data(), data.size()) / n;
+    }
+
+    template<bool Smallest>
+    Value extreme(Interpreter& interpreter, const BuiltinArgs& args) {
+        const char* function = Smallest ? "min" : "max";
+        const Value& values = nonEmptySequence(args, 0, function);
+        if (values.getType() == Type::RANGE) {
+            const Range& range = values.as<Range>();
+            int last = range.at(range.size() - 1);
+            bool ascending = range.step > 0;
+            return Smallest == ascending ? range.start : last;
+        }
+        ScratchArena::Frame frame(interpreter.getScratch());
+        if (hasOnlyInts(values)) {
+            auto data = packed<int>(interpreter, values);
+            return Smallest ? minOf(data.data(), data.size()) : maxOf(data.data(), data.size());
+        }
+        auto data = packed<double>(interpreter, values);
+        return Smallest ? minOf(data.data(), data.size()) : maxOf(data.data(), data.size());
+    }
+
+    Value dot(Interpreter& interpreter, const BuiltinArgs& args) {
+        const Value& left = *args[0];
+        const Value& right = *args[1];
+        if (left.length() != right.length()) {
+            throw std::runtime_error("dot: array length mismatch: " + std::to_string(left.length()) +
+                " and " + std::to_string(right.length()));
+        }
+        ScratchArena::Frame frame(interpreter.getScratch());
+        bool ints = hasOnlyInts(left);
+        ints = hasOnlyInts(right) && ints;
+        if (ints) {
+            auto a = packed<int>(interpreter, left);
+            auto b = packed<int>(interpreter, right);
+            return intResult(dotOf(a.data(), b.data(), a.size()), "dot");
+        }
+        auto a = packed<double>(interpreter, left);
+        auto b = packed<double>(interpreter, right);
+        return dotOf(a.data(), b.data(), a.size());
+    }
+
+    bool isNumber(Type type) {
+        return type == Type::INT || type == Type::DOUBLE;
+    }
+
+    double toDouble(const Value& number) {
+        return number.getType() == Type::INT ? number.as<int>() : number.as<double>();
+    }
+
+    // numbers order numerically, strings lexicographically, nothing else
+    // can be ordered
+    int compareElements(const Value& a, const Value& b, const char* function) {
+        Type left = a.getType();
+        Type right = b.getType();
+        if (left == Type::INT && right == Type::INT) {
+            return (a.as<int>() > b.as<int>()) - (a.as<int>() < b.as<int>());
+        }
+        if (isNumber(left) && isNumber(right)) {
+            double x = toDouble(a);
+            double y = toDouble(b);
+            return (x > y) - (x < y);
+        }
+        if (left == Type::STRING && right == Type::STRING) {
+            int order = a.as<SharedString>().view().compare(b.as<SharedString>().view());
+            return (order > 0) - (order < 0);
+        }
+        throw std::runtime_error(std::string(function) + ": cannot compare " + typeToString(left) +
+            " and " + typeToString(right));
+    }
+
+    bool sameElement(const Value& a, const Value& b) {
+        Type left = a.getType();
+        Type right = b.getType();
+        if (isNumber(left) && isNumber(right)) {
+            return compareElements(a, b, "unique") == 0;
+        }
+        if (left != right) {
+            return false;
+        }
+        switch (left) {
+        case Type::STRING: return a.as<SharedString>() == b.as<SharedString>();
+        case Type::BOOL: return a.as<bool>() == b.as<bool>();
+        default: return a.toString() == b.toString();
+        }
+    }
+
+    // sorts a homogeneous int or double array as packed numbers
+    template<typename T>
+    void sortPacked(Interpreter& interpreter, std::vector<Value>& elements) {
+        ScratchArena::Frame frame(interpreter.getScratch());
+        std::pmr::vector<T> data(&interpreter.getScratch());
+        data.reserve(elements.size());
+        for (const Value& element : elements) {
+            data.push_back(element.as<T>());
+        }
+        parallelSort(data.data(), data.size(), std::less<T>());
+        for (size_t i = 0; i < data.size(); ++i) {
+            elements[i] = data[i];
+        }
+    }
+
+    // sort(a), ascending, in place
+    Value sort(Interpreter& interpreter, const BuiltinArgs& args) {
+        // checked before anything is materialized or unshared, so a failing
+        // sort leaves a as it was
+        const Value& values = *args[0];
+        bool ints = true, doubles = true, strings = true, numbers = true;
+        for (size_t i = 0; i < values.length() && (numbers || strings); ++i) {
+            Type type = values.element(i).getType();
+            ints = ints && type == Type::INT;
+            doubles = doubles && type == Type::DOUBLE;
+            strings = strings && type == Type::STRING;
+            numbers = numbers && isNumber(type);
+        }
+        if (!numbers && !strings) {
+            throw std::runtime_error("sort: elements must be all numbers or all strings");
+        }
+
+        std::vector<Value>& elements = args[0]->elementsForWrite();
+        if (ints) {
+            sortPacked<int>(interpreter, elements);
+        }
+        else if (doubles) {
+            sortPacked<double>(interpreter, elements);
+        }
+        else if (strings) {
+            parallelSort(elements.data(), elements.size(), [](const Value& a, const Value& b) {
+                return a.as<SharedString>() < b.as<SharedString>();
+            });
+        }
+        else {
+            parallelSort(elements.data(), elements.size(), [](const Value& a, const Value& b) {
+                return compareElements(a, b, "sort") < 0;
+            });
+        }
+        return {};
+    }
+
+    // sortBy(a, "less") orders a with the script function less(x, y),
+    // which returns true if x goes before y. The comparator runs in the
+    // interpreter, so this sort is stable and sequential
+    Value sortBy(Interpreter& interpreter, const BuiltinArgs& args) {
+        SymbolId comparator = SymbolTable::intern(stringArgument(args, 1).str());
+        if (!interpreter.getEnvironment().hasFunction(comparator)) {
+            throw std::runtime_error("sortBy: no function named " + SymbolTable::name(comparator));
+        }
+
+        // positions are sorted on the side so a failing comparator leaves a
+        // untouched; a struct array's rows are gathered once, for the comparator
+        const Value& values = *args[0];
+        std::vector<Value> work;
+        work.reserve(values.length());
+        for (size_t i = 0; i < values.length(); ++i) {
+            work.push_back(values.element(i));
+        }
+        std::vector<size_t> order(work.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            ScratchArena::Frame frame(interpreter.getScratch());
+            std::pmr::vector<Value> pair(&interpreter.getScratch());
+            pair.reserve(2);
+            pair.push_back(work[a]);
+            pair.push_back(work[b]);
+            Value before = interpreter.callFunction(comparator, pair);
+            if (before.getType() != Type::BOOL) {
+                throw std::runtime_error("sortBy: comparator must return bool, got " + typeToString(before.getType()));
+            }
+            return before.as<bool>();
+        });
+
+        if (values.getType() == Type::STRUCT_ARRAY) {
+            args[0]->structArrayForWrite().permuteRows(order);
+            return {};
+        }
+        std::vector<Value> sorted;
+        sorted.reserve(order.size());
+        for (size_t i : order) {
+            sorted.push_back(std::move(work[i]));
+        }
+        args[0]->elementsForWrite() = std::move(sorted);
+        return {};
+    }
+
+    // binarySearch(a, x) on an ascending array or range, index of the first
+    // element equal to x or -1
+    Value binarySearch(Interpreter&, const BuiltinArgs& args) {
+        const Value& values = *args[0];
+        const Value& wanted = *args[1];
+        size_t lo = 0;
+        size_t hi = values.length();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (compareElements(values.element(mid), wanted, "binarySearch") < 0) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        if (lo < values.length() && compareElements(values.element(lo), wanted, "binarySearch") == 0) {
+            return static_cast<int>(lo);
+        }
+        return -1;
+    }
+
+    // unique(a) drops elements equal to the one before them, in place,
+    // and returns the new length
+    Value unique(Interpreter&, const BuiltinArgs& args) {
+        const Value& values = *args[0];
+        if (values.getType() == Type::RANGE && values.as<Range>().step != 0) {
+            return static_cast<int>(values.length()); // no two neighbours are equal
+        }
+        if (values.getType() == Type::STRUCT_ARRAY) {
+            // compared field by field, the columns are only rebuilt if a row goes
+            StructArray& structs = args[0]->structArrayForWrite();
+            size_t fields = structs.getLayout().fieldCount();
+            std::vector<bool> erased(structs.size());
+            size_t kept = structs.size() > 0 ? 1 : 0;
+            for (size_t row = 1, last = 0; row < structs.size(); ++row) {
+                size_t slot = 0;
+                while (slot < fields && sameElement(structs.get(row, slot), structs.get(last, slot))) {
+                    ++slot;
+                }
+                erased[row] = slot == fields;
+                if (!erased[row]) {
+                    last = row;
+                    ++kept;
+                }
+            }
+            if (kept < structs.size()) {
+                structs.eraseRows(erased);
+            }
+            return static_cast<int>(kept);
+        }
+        std::vector<Value>& elements = args[0]->elementsForWrite();
+        elements.erase(std::unique(elements.begin(), elements.end(), sameElement), elements.end());
+        return static_cast<int>(elements.size());
+    }
+
+    const Matrix& matrixArgument(const BuiltinArgs& args, size_t index) {
+        return args[index]->as<Matrix>();
+    }
+
+    size_t dimensionArgument(const BuiltinArgs& args, size_t index, const char* function) {
+        int size = intArgument(args, index);
+        if (size < 0) {
+            throw std::runtime_error(std::string(function) + ": negative dimension " + std::to_string(size));
+        }
+        return static_cast<size_t>(size);
+    }
+
+    Value zeros(Interpreter&, const BuiltinArgs& args) {
+        return Matrix(dimensionArgument(args, 0, "zeros"), dimensionArgument(args, 1, "zeros"));
+    }
+
+    Value identity(Interpreter&, const BuiltinArgs& args) {
+        size_t n = dimensionArgument(args, 0, "identity");
+        Matrix result(n, n);
+        double* data = result.mutableData();
+        for (size_t i = 0; i < n; ++i) {
+            data[i * n + i] = 1.0;
+        }
+        return result;
+    }
+
+    // reshape(a, rows, cols) fills a matrix row by row from a numeric array
+    Value reshape(Interpreter& interpreter, const BuiltinArgs& args) {
+        const Value& values = *args[0];
+        size_t rows = dimensionArgument(args, 1, "reshape");
+        size_t cols = dimensionArgument(args, 2, "reshape");
+        if (values.length() != rows * cols) {
+            throw std::runtime_error("reshape: " + std::to_string(values.length()) + " elements do not fill a " +
+                std::to_string(rows) + "x" + std::to_string(cols) + " matrix");
+        }
+        hasOnlyInts(values); // rejects non-numeric elements
+        ScratchArena::Frame frame(interpreter.getScratch());
+        auto data = packed<double>(interpreter, values);
+        Matrix result(rows, cols);
+        std::copy(data.begin(), data.end(), result.mutableData());
+        return result;
+    }
+
+    Value rows(Interpreter&, const BuiltinArgs& args) {
+        return static_cast<int>(matrixArgument(args, 0).rows());
+    }
+
+    Value cols(Interpreter&, const BuiltinArgs& args) {
+        return static_cast<int>(matrixArgument(args, 0).cols());
+    }
+
+    Value transpose(Interpreter&, const BuiltinArgs& args) {
+        const Matrix& matrix = matrixArgument(args, 0);
+        Matrix result(matrix.cols(), matrix.rows());
+        transposeMatrix(matrix.data(), matrix.rows(), matrix.cols(), result.mutableData());
+        return result;
+    }
+
+    Value matmul(Interpreter&, const BuiltinArgs& args) {
+        const Matrix& a = matrixArgument(args, 0);
+        const Matrix& b = matrixArgument(args, 1);
+        if (a.cols() != b.rows()) {
+            throw std::runtime_error("matmul: cannot multiply " + std::to_string(a.rows()) + "x" + std::to_string(a.cols()) +
+                " by " + std::to_string(b.rows()) + "x" + std::to_string(b.cols()));
+        }
+        Matrix result(a.rows(), b.cols());
+        multiplyMatrices(a.data(), b.data(), result.mutableData(), a.rows(), a.cols(), b.cols());
+        return result;
+    }
+
+    constexpr TypeSet INT = typeSet(Type::INT);
+    constexpr TypeSet STRING = typeSet(Type::STRING);
+    constexpr TypeSet MAP = typeSet(Type::MAP);
+    constexpr TypeSet MATRIX = typeSet(Type::MATRIX);
+    constexpr TypeSet SEQUENCE = SEQUENCE_TYPES;
+    constexpr TypeSet ANY = ANY_TYPE;
+
+    // name, required arguments, parameters, function, writes its first argument, takes a callback
+    Builtin standardBuiltins[] = {
+        { "range", 1, { INT, INT, INT }, range },
+        { "len", 1, { STRING | MAP | SEQUENCE }, len },
+        { "substr", 2, { STRING, INT, INT }, substr },
+        { "find", 2, { STRING, STRING, INT }, find },
+        { "split", 2, { STRING, STRING }, split },
+        { "startsWith", 2, { STRING, STRING }, startsWith },
+        { "has", 2, { MAP, ANY }, has },
+        { "remove", 2, { MAP, ANY }, remove, true },
+        { "keys", 1, { MAP }, keys },
+        { "sum", 1, { SEQUENCE }, sum },
+        { "mean", 1, { SEQUENCE }, mean },
+        { "min", 1, { SEQUENCE }, extreme<true> },
+        { "max", 1, { SEQUENCE }, extreme<false> },
+        { "dot", 2, { SEQUENCE, SEQUENCE }, dot },
+        { "sort", 1, { SEQUENCE }, sort, true },
+        { "sortBy", 2, { SEQUENCE, STRING }, sortBy, true, true },
+        { "binarySearch", 2, { SEQUENCE, ANY }, binarySearch },
+        { "unique", 1, { SEQUENCE }, unique, true },
+        { "zeros", 2, { INT, INT }, zeros },
+        { "identity", 1, { INT }, identity },
+        { "reshape", 3, { SEQUENCE, INT, INT }, reshape },
+        { "rows", 1, { MATRIX }, rows },
+        { "cols", 1, { MATRIX }, cols },
+        { "transpose", 1, { MATRIX }, transpose },
+        { "matmul", 2, { MATRIX, MATRIX }, matmul },
+    };
+
+    bool isIdentifier(const char* name) {
+        if (!name || !(std::isalpha(static_cast<unsigned char>(name[0])) || name[0] == '_')) {
+            return false;
+        }
+        for (const char* c = name + 1; *c; ++c) {
+            if (!std::isalnum(static_cast<unsigned char>(*c)) && *c != '_') {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+std::string typeSetToString(TypeSet types) {
+    std::vector<std::string> names;
+    for (int type = 0; typeSet(static_cast<Type>(type)) <= ANY_TYPE; ++type) {
+        if (types & typeSet(static_cast<Type>(type))) {
+            names.push_back(typeToString(static_cast<Type>(type)));
+        }
+    }
+    std::string text;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (i > 0) {
+            text += i + 1 == names.size() ? " or " : ", ";
+        }
+        text += names[i];
+    }
+    return text;
+}
+
+void Builtin::checkArguments(const BuiltinArgs& args) const {
+    for (size_t i = 0; i < args.size(); ++i) {
+        Type type = args[i]->getType();
+        if (!(params[i] & typeSet(type))) {
+            throw std::runtime_error(std::string(name) + ": argument " + std::to_string(i + 1) +
+                " must be " + typeSetToString(params[i]) + ", got " + typeToString(type));
+        }
+    }
+}
+
+BuiltinRegistry& BuiltinRegistry::instance() {
+    static BuiltinRegistry registry = [] {
+        BuiltinRegistry standard;
+        for (Builtin& builtin : standardBuiltins) {
+            standard.add(std::move(builtin));
+        }
+        return standard;
+    }();
+    return registry;
+}
+
+void BuiltinRegistry::add(Builtin builtin) {
+    std::string name = builtin.name ? builtin.name : "";
+    auto invalid = [&name](const std::string& reason) {
+        return std::runtime_error("builtin '" + name + "': " + reason);
+    };
+    if (!isIdentifier(builtin.name)) {
+        throw invalid("name is not an identifier");
+    }
+    if (!builtin.fn) {
+        throw invalid("no function");
+    }
+    if (builtin.minArgs > builtin.maxArgs()) {
+        throw invalid("requires " + std::to_string(builtin.minArgs) + " arguments but has " +
+            std::to_string(builtin.maxArgs()) + " parameters");
+    }
+    for (size_t i = 0; i < builtin.params.size(); ++i) {
+        if (builtin.params[i] == 0 || (builtin.params[i] & ~ANY_TYPE)) {
+            throw invalid("parameter " + std::to_string(i + 1) + " accepts no valid type");
+        }
+    }
+    if (builtin.writesFirstArgument && builtin.minArgs == 0) {
+        throw invalid("writes its first argument, which is optional");
+    }
+    if (builtin.takesCallback &&
+        std::none_of(builtin.params.begin(), builtin.params.end(), [](TypeSet types) { return types & typeSet(Type::STRING); })) {
+        throw invalid("takes a callback but no parameter accepts its name");
+    }
+
+    SymbolId symbol = SymbolTable::intern(name);
+    if (builtins.count(symbol)) {
+        throw invalid("already registered");
+    }
+    builtins.emplace(symbol, std::move(builtin));
+}
+
+const Builtin* BuiltinRegistry::find(SymbolId symbol) const {
+    auto it = builtins.find(symbol);
+    return it != builtins.end() ? &it->second : nullptr;
+}
+
+Value mapKeys(const HashMap& map) {
+    std::vector<Value> keys;
+    keys.reserve(map.size());
+    for (size_t slot = 0; slot < map.capacity(); ++slot) {
+        if (map.occupied(slot)) {
+            keys.push_back(map.keyAt(slot));
+        }
+    }
+    return { std::move(keys) };
+}
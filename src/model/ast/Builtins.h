@@ -0,0 +1,81 @@
+#ifndef SEASHELLS_BUILTINS_H
+#define SEASHELLS_BUILTINS_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../environment/Symbol.h"
+#include "../environment/Value.h"
+
+class HashMap;
+class Interpreter;
+
+// arguments are borrowed: a plain variable argument points straight at the
+// variable's storage, anything else at a temporary owned by the caller
+using BuiltinArgs = std::pmr::vector<Value*>;
+using BuiltinFn = Value (*)(Interpreter& interpreter, const BuiltinArgs& args);
+
+// the value types a builtin parameter accepts, one bit per Type
+using TypeSet = uint32_t;
+
+constexpr TypeSet typeSet(Type type) {
+    return TypeSet(1) << static_cast<int>(type);
+}
+
+template<typename... Types>
+constexpr TypeSet typeSet(Type type, Types... more) {
+    return typeSet(type) | typeSet(more...);
+}
+
+constexpr TypeSet ANY_TYPE = (typeSet(Type::STRUCT_ARRAY) << 1) - 1;
+constexpr TypeSet SEQUENCE_TYPES = typeSet(Type::ARRAY, Type::RANGE, Type::STRUCT_ARRAY);
+
+// "int", "int or double", "array, range or struct array"
+std::string typeSetToString(TypeSet types);
+
+// function implemented natively and callable like a script function; the
+// arguments are checked against params before fn runs, so fn may take
+// each one's type for granted
+struct Builtin {
+    const char* name;
+    size_t minArgs;               // parameters past these are optional
+    std::vector<TypeSet> params;  // what each parameter accepts
+    BuiltinFn fn;
+    bool writesFirstArgument = false; // updates its first argument in place
+    bool takesCallback = false;       // calls a script function named by an argument
+
+    size_t maxArgs() const { return params.size(); }
+
+    // throws naming the first argument of a type its parameter doesn't accept
+    void checkArguments(const BuiltinArgs& args) const;
+};
+
+// every builtin by name. A signature is validated once, when its builtin
+// is added; builtins have to be added before any script runs, lookups are
+// then safe from any thread
+class BuiltinRegistry {
+public:
+    // starts out holding the standard builtins
+    static BuiltinRegistry& instance();
+
+    // throws if the signature is inconsistent or the name is taken
+    void add(Builtin builtin);
+
+    // null if no builtin has this name
+    const Builtin* find(SymbolId symbol) const;
+
+private:
+    std::unordered_map<SymbolId, Builtin> builtins; // nodes never move, pointers stay valid
+};
+
+// the keys of a map as an array, in table order
+Value mapKeys(const HashMap& map);
+
+// null if no builtin has this name
+inline const Builtin* findBuiltin(SymbolId symbol) {
+    return BuiltinRegistry::instance().find(symbol);
+}
+
+#endif //SEASHELLS_BUILTINS_H
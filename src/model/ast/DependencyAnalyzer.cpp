@@ -0,0 +1,310 @@
+#include "DependencyAnalyzer.h"
+#include "Builtins.h"
+#include <algorithm>
+#include <unordered_map>
+
+StatementEffects DependencyAnalyzer::analyze(ASTNode& statement) {
+    effects = StatementEffects{};
+    scopes.assign(1, {});
+    inFunction = false;
+    visitedFunctions.clear();
+    statement.accept(*this);
+    return std::move(effects);
+}
+
+std::vector<size_t> DependencyAnalyzer::waves(const std::vector<StatementEffects>& statements) {
+    // per global, the latest wave writing it and the latest wave reading it;
+    // writers of one global are chained, so the last writer is the latest
+    std::unordered_map<SymbolId, size_t> writtenIn;
+    std::unordered_map<SymbolId, size_t> readIn;
+    std::vector<size_t> result;
+    result.reserve(statements.size());
+
+    for (const StatementEffects& statement : statements) {
+        size_t wave = 0;
+        auto after = [&wave](const std::unordered_map<SymbolId, size_t>& last, SymbolId symbol) {
+            auto it = last.find(symbol);
+            if (it != last.end()) {
+                wave = std::max(wave, it->second + 1);
+            }
+        };
+        for (SymbolId symbol : statement.reads) {
+            after(writtenIn, symbol);
+        }
+        for (SymbolId symbol : statement.writes) {
+            after(writtenIn, symbol);
+            after(readIn, symbol);
+        }
+
+        for (SymbolId symbol : statement.reads) {
+            size_t& latest = readIn[symbol];
+            latest = std::max(latest, wave);
+        }
+        for (SymbolId symbol : statement.writes) {
+            writtenIn[symbol] = wave;
+        }
+        result.push_back(wave);
+    }
+    return result;
+}
+
+bool DependencyAnalyzer::isLocal(SymbolId symbol) const {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+        if (it->count(symbol)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DependencyAnalyzer::read(SymbolId symbol) {
+    if (!isLocal(symbol)) {
+        effects.reads.insert(symbol);
+    }
+}
+
+void DependencyAnalyzer::write(SymbolId symbol) {
+    if (!isLocal(symbol)) {
+        effects.writes.insert(symbol);
+    }
+}
+
+void DependencyAnalyzer::followFunction(FunctionNode& callee) {
+    if (!visitedFunctions.insert(&callee).second) {
+        return;
+    }
+    prepare(callee);
+
+    // a function only sees its parameters and the globals
+    std::vector<std::unordered_set<SymbolId>> savedScopes(1);
+    for (const auto& param : callee.getParameters()) {
+        savedScopes.back().insert(param.first);
+    }
+    std::swap(scopes, savedScopes);
+    bool savedInFunction = inFunction;
+    inFunction = true;
+
+    visitChild(callee.getBody());
+
+    std::swap(scopes, savedScopes);
+    inFunction = savedInFunction;
+}
+
+Value DependencyAnalyzer::visit(BreakNode&) {
+    return {};
+}
+
+Value DependencyAnalyzer::visit(ContinueNode&) {
+    return {};
+}
+
+Value DependencyAnalyzer::visit(LiteralNode&) {
+    return {};
+}
+
+Value DependencyAnalyzer::visit(VariableNode& node) {
+    read(node.getSymbol());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(ArrayNode& node) {
+    for (auto& element : node.getElements()) {
+        visitChild(element);
+    }
+    return {};
+}
+
+Value DependencyAnalyzer::visit(ArrayAllocNode& node) {
+    visitChild(node.getSize());
+    visitChild(node.getInitializer());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(ArrayAccessNode& node) {
+    visitChild(node.getIndex());
+    visitChild(node.getColumn());
+    read(node.getSymbol());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(StructDeclNode&) {
+    effects.barrier = true;
+    return {};
+}
+
+Value DependencyAnalyzer::visit(StructAllocNode& node) {
+    visitChild(node.getSize());
+    visitChild(node.getInitializer());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(FieldAccessNode& node) {
+    visitChild(node.getObject());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(FieldAssignmentNode& node) {
+    visitChild(node.getExpression());
+    ASTNode& object = *node.getObject();
+    visitChild(node.getObject());
+    if (object.getNodeType() == ASTNode::NodeType::ArrayAccess) {
+        write(static_cast<ArrayAccessNode&>(object).getSymbol());
+    }
+    else if (object.getNodeType() == ASTNode::NodeType::Variable) {
+        write(static_cast<VariableNode&>(object).getSymbol());
+    }
+    return {};
+}
+
+Value DependencyAnalyzer::visit(UnaryOpNode& node) {
+    visitChild(node.getOperand());
+    Operator op = node.getOperator();
+    bool step = op == Operator::PreIncrement || op == Operator::PostIncrement ||
+        op == Operator::PreDecrement || op == Operator::PostDecrement;
+    if (step && node.getOperand()->getNodeType() == ASTNode::NodeType::Variable) {
+        write(static_cast<VariableNode&>(*node.getOperand()).getSymbol());
+    }
+    return {};
+}
+
+Value DependencyAnalyzer::visit(BinOpNode& node) {
+    visitChild(node.getLeft());
+    visitChild(node.getRight());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(AssignmentNode& node) {
+    SymbolId symbol = node.getSymbol();
+    visitChild(node.getExpression());
+    if (node.getDeclType() != Type::VOID) {
+        if (!inFunction && scopes.size() == 1) {
+            effects.writes.insert(symbol);
+            effects.declares.push_back(symbol);
+        }
+        scopes.back().insert(symbol);
+        return {};
+    }
+    if (node.checkIfArrayAssignment()) {
+        visitChild(node.getIndex());
+        visitChild(node.getColumn());
+        // the element is updated in place, the rest of the array is kept
+        read(symbol);
+    }
+    write(symbol);
+    return {};
+}
+
+Value DependencyAnalyzer::visit(BlockNode& node) {
+    if (node.shouldCreateScope()) {
+        scopes.emplace_back();
+    }
+    for (auto& statement : node.getStatements()) {
+        visitChild(statement);
+    }
+    if (node.shouldCreateScope()) {
+        scopes.pop_back();
+    }
+    return {};
+}
+
+Value DependencyAnalyzer::visit(IfNode& node) {
+    visitChild(node.getCondition());
+    visitChild(node.getThenBranch());
+    visitChild(node.getElseBranch());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(WhileNode& node) {
+    visitChild(node.getCondition());
+    visitChild(node.getBody());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(ForNode& node) {
+    scopes.emplace_back();
+    visitChild(node.getInitialization());
+    visitChild(node.getCondition());
+    visitChild(node.getIncrement());
+    visitChild(node.getBody());
+    scopes.pop_back();
+    return {};
+}
+
+Value DependencyAnalyzer::visit(ForEachNode& node) {
+    visitChild(node.getSequence());
+    scopes.emplace_back();
+    scopes.back().insert(node.getSymbol());
+    visitChild(node.getBody());
+    scopes.pop_back();
+    return {};
+}
+
+Value DependencyAnalyzer::visit(ParallelForNode& node) {
+    ForNode& loop = node.getLoop();
+    scopes.emplace_back();
+    visitChild(loop.getInitialization());
+    visitChild(loop.getCondition());
+    visitChild(loop.getIncrement());
+    visitChild(loop.getBody());
+    scopes.pop_back();
+    // reductions are summed into the variables once the loop is done
+    for (SymbolId symbol : node.getReductions()) {
+        read(symbol);
+        write(symbol);
+    }
+    return {};
+}
+
+Value DependencyAnalyzer::visit(FunctionNode&) {
+    effects.barrier = true;
+    return {};
+}
+
+Value DependencyAnalyzer::visit(ReturnNode& node) {
+    visitChild(node.getExpression());
+    return {};
+}
+
+Value DependencyAnalyzer::visit(CallNode& node) {
+    auto& arguments = node.getArguments();
+    for (auto& argument : arguments) {
+        argument->accept(*this);
+    }
+
+    // same lookup order as the interpreter: script functions shadow builtins
+    if (FunctionNode* callee = env.findFunction(node.getSymbol())) {
+        followFunction(*callee);
+        return {};
+    }
+    const Builtin* builtin = findBuiltin(node.getSymbol());
+    if (!builtin) {
+        return {};
+    }
+    if (builtin->writesFirstArgument && !arguments.empty() &&
+        arguments.front()->getNodeType() == ASTNode::NodeType::Variable) {
+        write(static_cast<VariableNode&>(*arguments.front()).getSymbol());
+    }
+    if (!builtin->takesCallback) {
+        return {};
+    }
+
+    // callbacks are passed by name, one only known at run time could be anything
+    bool named = false;
+    for (auto& argument : arguments) {
+        if (argument->getNodeType() != ASTNode::NodeType::Literal) {
+            continue;
+        }
+        Value name = static_cast<LiteralNode&>(*argument).getValue();
+        if (name.getType() != Type::STRING) {
+            continue;
+        }
+        if (FunctionNode* callback = env.findFunction(SymbolTable::intern(name.as<SharedString>().str()))) {
+            followFunction(*callback);
+            named = true;
+        }
+    }
+    if (!named) {
+        effects.barrier = true;
+    }
+    return {};
+}
@@ -0,0 +1,79 @@
+#ifndef SEASHELLS_DEPENDENCYANALYZER_H
+#define SEASHELLS_DEPENDENCYANALYZER_H
+
+#include "ASTVisitor.h"
+#include "../environment/Environment.h"
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+// what a top-level statement does to the globals, called functions included
+struct StatementEffects {
+    std::unordered_set<SymbolId> reads;
+    std::unordered_set<SymbolId> writes;   // declared globals count as written
+    std::vector<SymbolId> declares;        // globals the statement declares itself
+    bool barrier = false;                  // changes functions or structs, or calls back by computed name
+};
+
+// works out which globals each top-level statement of a script reads and
+// writes, so statements that don't touch each other's globals can run at
+// the same time. A statement whose effects can't be known up front is a
+// barrier and has to run on its own
+class DependencyAnalyzer : public ASTVisitor {
+public:
+    // prepare parses a function's body when it was deferred
+    DependencyAnalyzer(Environment& env, std::function<void(FunctionNode&)> prepare)
+        : env(env), prepare(std::move(prepare)) {}
+
+    StatementEffects analyze(ASTNode& statement);
+
+    // wave of each statement: a statement goes one wave after the latest
+    // earlier statement it conflicts with, statements of a wave are independent
+    static std::vector<size_t> waves(const std::vector<StatementEffects>& statements);
+
+    Value visit(BreakNode& node) override;
+    Value visit(ContinueNode& node) override;
+    Value visit(LiteralNode& node) override;
+    Value visit(VariableNode& node) override;
+    Value visit(ArrayNode& node) override;
+    Value visit(ArrayAllocNode& node) override;
+    Value visit(ArrayAccessNode& node) override;
+    Value visit(StructDeclNode& node) override;
+    Value visit(StructAllocNode& node) override;
+    Value visit(FieldAccessNode& node) override;
+    Value visit(FieldAssignmentNode& node) override;
+    Value visit(UnaryOpNode& node) override;
+    Value visit(BinOpNode& node) override;
+    Value visit(AssignmentNode& node) override;
+    Value visit(BlockNode& node) override;
+    Value visit(IfNode& node) override;
+    Value visit(WhileNode& node) override;
+    Value visit(ForNode& node) override;
+    Value visit(ForEachNode& node) override;
+    Value visit(ParallelForNode& node) override;
+    Value visit(FunctionNode& node) override;
+    Value visit(ReturnNode& node) override;
+    Value visit(CallNode& node) override;
+
+private:
+    Environment& env;
+    std::function<void(FunctionNode&)> prepare;
+
+    StatementEffects effects;
+    std::vector<std::unordered_set<SymbolId>> scopes; // names declared inside the statement
+    bool inFunction = false;
+    std::unordered_set<const FunctionNode*> visitedFunctions;
+
+    void visitChild(std::unique_ptr<ASTNode>& node) {
+        if (node) {
+            node->accept(*this);
+        }
+    }
+
+    bool isLocal(SymbolId symbol) const;
+    void read(SymbolId symbol);
+    void write(SymbolId symbol);
+    void followFunction(FunctionNode& callee);
+};
+
+#endif //SEASHELLS_DEPENDENCYANALYZER_H
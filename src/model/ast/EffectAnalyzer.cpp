@@ -0,0 +1,375 @@
+#include "EffectAnalyzer.h"
+#include "Builtins.h"
+#include <algorithm>
+
+std::vector<SymbolId> EffectAnalyzer::analyze(ASTNode& body, SymbolId counter, const std::vector<SymbolId>& reductions) {
+    this->counter = counter;
+    this->reductions = std::unordered_set<SymbolId>(reductions.begin(), reductions.end());
+    if (this->reductions.count(counter)) {
+        reject("the loop counter can't be a reduction variable");
+    }
+    scopes.assign(1, {});
+    body.accept(*this);
+
+    for (SymbolId array : sharedWrites) {
+        if (looseUses.count(array)) {
+            reject("'" + SymbolTable::name(array) + "' is written as " + SymbolTable::name(array) + "[" +
+                SymbolTable::name(counter) + "], so it can't be used any other way in the loop");
+        }
+    }
+    return sharedWrites;
+}
+
+void EffectAnalyzer::reject(const std::string& reason) const {
+    if (function) {
+        throw std::runtime_error("parallel for: " + reason + " (in function " + function->getName() + ")");
+    }
+    throw std::runtime_error("parallel for: " + reason);
+}
+
+bool EffectAnalyzer::isLocal(SymbolId symbol) const {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+        if (it->count(symbol)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EffectAnalyzer::isCounterIndexed(ASTNode& index, const std::unique_ptr<ASTNode>& column) const {
+    return !function && !column && !isLocal(counter) && index.getNodeType() == ASTNode::NodeType::Variable &&
+        static_cast<VariableNode&>(index).getSymbol() == counter;
+}
+
+void EffectAnalyzer::checkOuterArrayWrite(SymbolId array, ASTNode& index, const std::unique_ptr<ASTNode>& column) {
+    if (isLocal(array)) {
+        return;
+    }
+    if (!function && (array == counter || reductions.count(array))) {
+        reject("can't index into '" + SymbolTable::name(array) + "'");
+    }
+    if (!isCounterIndexed(index, column)) {
+        reject("outer array '" + SymbolTable::name(array) + "' can only be written at " +
+            SymbolTable::name(array) + "[" + SymbolTable::name(counter) + "]");
+    }
+    if (std::find(sharedWrites.begin(), sharedWrites.end(), array) == sharedWrites.end()) {
+        sharedWrites.push_back(array);
+    }
+}
+
+// the only use of a reduction variable: s = s + e, s = e + s or s = s - e
+void EffectAnalyzer::checkReductionUpdate(SymbolId symbol, ASTNode& expression) {
+    auto isSelf = [symbol](ASTNode& operand) {
+        return operand.getNodeType() == ASTNode::NodeType::Variable &&
+            static_cast<VariableNode&>(operand).getSymbol() == symbol;
+    };
+    if (expression.getNodeType() == ASTNode::NodeType::BinaryOp) {
+        auto& update = static_cast<BinOpNode&>(expression);
+        Operator op = update.getOperator();
+        if ((op == Operator::Add || op == Operator::Subtract) && isSelf(*update.getLeft())) {
+            update.getRight()->accept(*this);
+            return;
+        }
+        if (op == Operator::Add && isSelf(*update.getRight())) {
+            update.getLeft()->accept(*this);
+            return;
+        }
+    }
+    reject("reduction variable '" + SymbolTable::name(symbol) + "' can only be updated as " +
+        SymbolTable::name(symbol) + " = " + SymbolTable::name(symbol) + " + ...");
+}
+
+void EffectAnalyzer::checkFunction(FunctionNode& callee) {
+    if (!checkedFunctions.insert(&callee).second) {
+        return;
+    }
+    prepare(callee);
+
+    // a function only sees its parameters and the globals
+    std::vector<std::unordered_set<SymbolId>> savedScopes(1);
+    for (const auto& param : callee.getParameters()) {
+        savedScopes.back().insert(param.first);
+    }
+    std::swap(scopes, savedScopes);
+    const FunctionNode* savedFunction = function;
+    size_t savedDepth = loopDepth;
+    function = &callee;
+    loopDepth = 0;
+
+    visitChild(callee.getBody());
+
+    std::swap(scopes, savedScopes);
+    function = savedFunction;
+    loopDepth = savedDepth;
+}
+
+Value EffectAnalyzer::visit(BreakNode&) {
+    if (loopDepth == 0 && !function) {
+        reject("break would leave the loop early");
+    }
+    return {};
+}
+
+Value EffectAnalyzer::visit(ContinueNode&) {
+    return {};
+}
+
+Value EffectAnalyzer::visit(LiteralNode&) {
+    return {};
+}
+
+Value EffectAnalyzer::visit(VariableNode& node) {
+    SymbolId symbol = node.getSymbol();
+    if (isLocal(symbol)) {
+        return {};
+    }
+    if (!function) {
+        if (reductions.count(symbol)) {
+            reject("reduction variable '" + SymbolTable::name(symbol) + "' can't be read inside the loop");
+        }
+        if (symbol == counter) {
+            return {};
+        }
+    }
+    looseUses.insert(symbol);
+    return {};
+}
+
+Value EffectAnalyzer::visit(ArrayNode& node) {
+    for (auto& element : node.getElements()) {
+        visitChild(element);
+    }
+    return {};
+}
+
+Value EffectAnalyzer::visit(ArrayAllocNode& node) {
+    visitChild(node.getSize());
+    visitChild(node.getInitializer());
+    return {};
+}
+
+Value EffectAnalyzer::visit(ArrayAccessNode& node) {
+    visitChild(node.getIndex());
+    visitChild(node.getColumn());
+    SymbolId array = node.getSymbol();
+    if (isLocal(array)) {
+        return {};
+    }
+    if (!function && reductions.count(array)) {
+        reject("reduction variable '" + SymbolTable::name(array) + "' can't be read inside the loop");
+    }
+    if (!isCounterIndexed(*node.getIndex(), node.getColumn())) {
+        looseUses.insert(array);
+    }
+    return {};
+}
+
+Value EffectAnalyzer::visit(StructDeclNode& node) {
+    reject("struct " + SymbolTable::name(node.getSymbol()) + " can't be declared inside the loop");
+}
+
+Value EffectAnalyzer::visit(StructAllocNode& node) {
+    visitChild(node.getSize());
+    visitChild(node.getInitializer());
+    return {};
+}
+
+Value EffectAnalyzer::visit(FieldAccessNode& node) {
+    visitChild(node.getObject());
+    return {};
+}
+
+Value EffectAnalyzer::visit(FieldAssignmentNode& node) {
+    visitChild(node.getExpression());
+    ASTNode& object = *node.getObject();
+    if (object.getNodeType() == ASTNode::NodeType::ArrayAccess) {
+        auto& access = static_cast<ArrayAccessNode&>(object);
+        visitChild(access.getIndex());
+        visitChild(access.getColumn());
+        checkOuterArrayWrite(access.getSymbol(), *access.getIndex(), access.getColumn());
+        return {};
+    }
+    if (object.getNodeType() == ASTNode::NodeType::Variable) {
+        SymbolId symbol = static_cast<VariableNode&>(object).getSymbol();
+        if (!isLocal(symbol)) {
+            reject("can't modify outer variable '" + SymbolTable::name(symbol) + "'");
+        }
+    }
+    return {};
+}
+
+Value EffectAnalyzer::visit(UnaryOpNode& node) {
+    Operator op = node.getOperator();
+    bool step = op == Operator::PreIncrement || op == Operator::PostIncrement ||
+        op == Operator::PreDecrement || op == Operator::PostDecrement;
+    ASTNode& operand = *node.getOperand();
+    if (!step || operand.getNodeType() != ASTNode::NodeType::Variable) {
+        visitChild(node.getOperand());
+        return {};
+    }
+
+    SymbolId symbol = static_cast<VariableNode&>(operand).getSymbol();
+    if (isLocal(symbol)) {
+        return {};
+    }
+    if (!function && reductions.count(symbol)) {
+        // s++ adds one per iteration, that sums up like any other update
+        return {};
+    }
+    if (!function && symbol == counter) {
+        reject("the loop counter can't be changed inside the loop");
+    }
+    reject("can't modify outer variable '" + SymbolTable::name(symbol) + "'");
+}
+
+Value EffectAnalyzer::visit(BinOpNode& node) {
+    visitChild(node.getLeft());
+    visitChild(node.getRight());
+    return {};
+}
+
+Value EffectAnalyzer::visit(AssignmentNode& node) {
+    SymbolId symbol = node.getSymbol();
+    if (node.getDeclType() != Type::VOID) {
+        visitChild(node.getExpression());
+        declare(symbol);
+        return {};
+    }
+    if (node.checkIfArrayAssignment()) {
+        visitChild(node.getExpression());
+        visitChild(node.getIndex());
+        visitChild(node.getColumn());
+        checkOuterArrayWrite(symbol, *node.getIndex(), node.getColumn());
+        return {};
+    }
+    if (isLocal(symbol)) {
+        visitChild(node.getExpression());
+        return {};
+    }
+    if (!function && reductions.count(symbol)) {
+        checkReductionUpdate(symbol, *node.getExpression());
+        return {};
+    }
+    if (!function && symbol == counter) {
+        reject("the loop counter can't be changed inside the loop");
+    }
+    if (function) {
+        reject("can't assign global '" + SymbolTable::name(symbol) + "'");
+    }
+    reject("can't assign outer variable '" + SymbolTable::name(symbol) + "', sum into it with parallel(" +
+        SymbolTable::name(symbol) + ") or declare it inside the loop");
+}
+
+Value EffectAnalyzer::visit(BlockNode& node) {
+    if (node.shouldCreateScope()) {
+        scopes.emplace_back();
+    }
+    for (auto& statement : node.getStatements()) {
+        visitChild(statement);
+    }
+    if (node.shouldCreateScope()) {
+        scopes.pop_back();
+    }
+    return {};
+}
+
+Value EffectAnalyzer::visit(IfNode& node) {
+    visitChild(node.getCondition());
+    visitChild(node.getThenBranch());
+    visitChild(node.getElseBranch());
+    return {};
+}
+
+Value EffectAnalyzer::visit(WhileNode& node) {
+    visitChild(node.getCondition());
+    loopDepth++;
+    visitChild(node.getBody());
+    loopDepth--;
+    return {};
+}
+
+Value EffectAnalyzer::visit(ForNode& node) {
+    scopes.emplace_back();
+    visitChild(node.getInitialization());
+    visitChild(node.getCondition());
+    visitChild(node.getIncrement());
+    loopDepth++;
+    visitChild(node.getBody());
+    loopDepth--;
+    scopes.pop_back();
+    return {};
+}
+
+Value EffectAnalyzer::visit(ForEachNode& node) {
+    visitChild(node.getSequence());
+    scopes.emplace_back();
+    declare(node.getSymbol());
+    loopDepth++;
+    visitChild(node.getBody());
+    loopDepth--;
+    scopes.pop_back();
+    return {};
+}
+
+Value EffectAnalyzer::visit(ParallelForNode&) {
+    reject("parallel for loops can't be nested");
+}
+
+Value EffectAnalyzer::visit(FunctionNode& node) {
+    reject("function " + node.getName() + " can't be declared inside the loop");
+}
+
+Value EffectAnalyzer::visit(ReturnNode& node) {
+    if (!function) {
+        reject("return would leave the loop early");
+    }
+    visitChild(node.getExpression());
+    return {};
+}
+
+Value EffectAnalyzer::visit(CallNode& node) {
+    const auto& arguments = node.getArguments();
+    for (const auto& argument : arguments) {
+        argument->accept(*this);
+    }
+
+    // same lookup order as the interpreter: script functions shadow builtins
+    if (FunctionNode* callee = env.findFunction(node.getSymbol())) {
+        checkFunction(*callee);
+        return {};
+    }
+    const Builtin* builtin = findBuiltin(node.getSymbol());
+    if (!builtin) {
+        return {};
+    }
+    if (builtin->writesFirstArgument && !arguments.empty()) {
+        ASTNode& first = *arguments.front();
+        if (first.getNodeType() != ASTNode::NodeType::Variable ||
+            !isLocal(static_cast<VariableNode&>(first).getSymbol())) {
+            reject(std::string(builtin->name) + " can only modify variables declared inside the loop");
+        }
+    }
+    if (!builtin->takesCallback) {
+        return {};
+    }
+
+    // callbacks are passed by name; only one spelled out as a literal can be
+    // checked, and have its body prepared, before the workers start
+    for (size_t i = 0; i < arguments.size() && i < builtin->params.size(); ++i) {
+        if (!(builtin->params[i] & typeSet(Type::STRING))) {
+            continue;
+        }
+        FunctionNode* callback = nullptr;
+        if (arguments[i]->getNodeType() == ASTNode::NodeType::Literal) {
+            Value name = static_cast<LiteralNode&>(*arguments[i]).getValue();
+            if (name.getType() == Type::STRING) {
+                callback = env.findFunction(SymbolTable::intern(name.as<SharedString>().str()));
+            }
+        }
+        if (!callback) {
+            reject(std::string(builtin->name) + "'s callback has to be a string literal naming a function");
+        }
+        checkFunction(*callback);
+    }
+    return {};
+}
@@ -0,0 +1,80 @@
+#ifndef SEASHELLS_EFFECTANALYZER_H
+#define SEASHELLS_EFFECTANALYZER_H
+
+#include "ASTVisitor.h"
+#include "../environment/Environment.h"
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+// checks before a parallel for runs that its iterations can't interfere:
+// outside of the loop body only a[i] of arrays may be written, i being the
+// loop counter, such arrays are never touched any other way, and the
+// reduction variables only ever grow by s = s + e or s = s - e. Called
+// functions are followed, they may not write anything but their own
+// locals; a builtin's callback has to be named by a string literal so it
+// can be followed too. Violations are reported as runtime errors
+class EffectAnalyzer : public ASTVisitor {
+public:
+    // prepare parses a function's body when it was deferred
+    EffectAnalyzer(Environment& env, std::function<void(FunctionNode&)> prepare)
+        : env(env), prepare(std::move(prepare)) {}
+
+    // the outer arrays the loop writes through a[counter]
+    std::vector<SymbolId> analyze(ASTNode& body, SymbolId counter, const std::vector<SymbolId>& reductions);
+
+    Value visit(BreakNode& node) override;
+    Value visit(ContinueNode& node) override;
+    Value visit(LiteralNode& node) override;
+    Value visit(VariableNode& node) override;
+    Value visit(ArrayNode& node) override;
+    Value visit(ArrayAllocNode& node) override;
+    Value visit(ArrayAccessNode& node) override;
+    Value visit(StructDeclNode& node) override;
+    Value visit(StructAllocNode& node) override;
+    Value visit(FieldAccessNode& node) override;
+    Value visit(FieldAssignmentNode& node) override;
+    Value visit(UnaryOpNode& node) override;
+    Value visit(BinOpNode& node) override;
+    Value visit(AssignmentNode& node) override;
+    Value visit(BlockNode& node) override;
+    Value visit(IfNode& node) override;
+    Value visit(WhileNode& node) override;
+    Value visit(ForNode& node) override;
+    Value visit(ForEachNode& node) override;
+    Value visit(ParallelForNode& node) override;
+    Value visit(FunctionNode& node) override;
+    Value visit(ReturnNode& node) override;
+    Value visit(CallNode& node) override;
+
+private:
+    Environment& env;
+    std::function<void(FunctionNode&)> prepare;
+
+    SymbolId counter = NO_SYMBOL;
+    std::unordered_set<SymbolId> reductions;
+    std::vector<std::unordered_set<SymbolId>> scopes; // names declared inside the body
+    const FunctionNode* function = nullptr;           // callee being checked, if any
+    size_t loopDepth = 0;
+
+    std::vector<SymbolId> sharedWrites;     // a of a[i] = ..., in order of appearance
+    std::unordered_set<SymbolId> looseUses; // outer names read other than as a[i]
+    std::unordered_set<const FunctionNode*> checkedFunctions;
+
+    void visitChild(std::unique_ptr<ASTNode>& node) {
+        if (node) {
+            node->accept(*this);
+        }
+    }
+
+    bool isLocal(SymbolId symbol) const;
+    void declare(SymbolId symbol) { scopes.back().insert(symbol); }
+    // a[i] with i the loop counter, in the loop body itself
+    bool isCounterIndexed(ASTNode& index, const std::unique_ptr<ASTNode>& column) const;
+    void checkOuterArrayWrite(SymbolId array, ASTNode& index, const std::unique_ptr<ASTNode>& column);
+    void checkReductionUpdate(SymbolId symbol, ASTNode& expression);
+    void checkFunction(FunctionNode& callee);
+    [[noreturn]] void reject(const std::string& reason) const;
+};
+
+#endif //SEASHELLS_EFFECTANALYZER_H
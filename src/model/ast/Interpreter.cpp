@@ -1,4 +1,9 @@
 #include "Interpreter.h"
+#include "ArrayArithmetic.h"
+#include "EffectAnalyzer.h"
+#include "../kernels/ThreadPool.h"
+#include "../environment/HashMap.h"
+#include "../parser/Parser.h"
 
 Value Interpreter::visit(BreakNode& node) {
     throw std::runtime_error("break encountered");
@@ -13,30 +18,283 @@ Value Interpreter::visit(LiteralNode& node) {
 }
 
 Value Interpreter::visit(VariableNode& node) {
-    return env.getVariable(node.toString()).value;
+    return env.getVariable(node.getSymbol()).value;
 }
 
 Value Interpreter::visit(ArrayNode& node) {
+    // the elements become the array value itself, so they are built on the
+    // regular heap in one allocation and moved out rather than copied
     std::vector<Value> evaluatedElements;
+    evaluatedElements.reserve(node.getElements().size());
     for (auto& element : node.getElements()) {
         evaluatedElements.push_back(evaluate(*element));
     }
-    return { evaluatedElements };
+    return { std::move(evaluatedElements) };
 }
 
-Value Interpreter::visit(ArrayAccessNode& node) {
-    auto var = env.getVariable(node.getName());
-    if (var.type == Type::ARRAY) {
-        auto array = var.value.get<std::vector<Value>>();
-        auto id = evaluate(*node.getIndex());
-        if (id.getType() != Type::INT) {
+Value Interpreter::visit(ArrayAllocNode& node) {
+    int size = -1;
+    if (auto& sizeExpr = node.getSize()) {
+        Value sizeVal = evaluate(*sizeExpr);
+        if (sizeVal.getType() != Type::INT) {
+            throw std::runtime_error("array size must be an integer");
+        }
+        size = sizeVal.get<int>();
+        if (size < 0) {
+            throw std::runtime_error("array size must not be negative");
+        }
+    }
+
+    if (auto& initializer = node.getInitializer()) {
+        Value initial = evaluate(*initializer);
+        if (!initial.isSequence()) {
+            throw std::runtime_error("array initializer must be an array");
+        }
+        size_t initialSize = initial.length();
+        if (size >= 0 && initialSize > static_cast<size_t>(size)) {
+            throw std::runtime_error("array initializer size " + std::to_string(initialSize) +
+                " exceeds specified size " + std::to_string(size));
+        }
+        return initial;
+    }
+
+    // one allocation, every slot copied from the same default value
+    return { std::vector<Value>(static_cast<size_t>(size), Value::defaultFor(node.getElemType())) };
+}
+
+namespace {
+    // flat position of m[row][col], after checking both indices
+    size_t matrixOffset(const Matrix& matrix, const Value& row, const Value& col) {
+        if (row.getType() != Type::INT || col.getType() != Type::INT) {
             throw std::runtime_error("index must be integer");
         }
-        else {
-            return array[id.get<int>()];
+        int i = row.as<int>();
+        int j = col.as<int>();
+        if (i < 0 || j < 0 || static_cast<size_t>(i) >= matrix.rows() || static_cast<size_t>(j) >= matrix.cols()) {
+            throw std::runtime_error("matrix index out of bounds: [" + std::to_string(i) + "][" + std::to_string(j) + "]");
+        }
+        return static_cast<size_t>(i) * matrix.cols() + j;
+    }
+
+    // position of a[index] in a sequence, after checking the index
+    size_t sequenceIndex(const Value& sequence, const Value& index) {
+        if (index.getType() != Type::INT) {
+            throw std::runtime_error("index must be integer");
+        }
+        int i = index.as<int>();
+        if (i < 0 || static_cast<size_t>(i) >= sequence.length()) {
+            throw std::runtime_error("array index out of bounds: " + std::to_string(i));
+        }
+        return static_cast<size_t>(i);
+    }
+
+    // container[id] for everything a single index can select from
+    Value elementAt(const Value& container, const Value& id) {
+        if (container.isSequence()) {
+            return container.element(sequenceIndex(container, id));
+        }
+        if (container.getType() == Type::MAP) {
+            const Value* found = container.as<Map>().read().find(id);
+            if (!found) {
+                HashMap::checkKey(id);
+                throw std::runtime_error("key not found: " + id.toString());
+            }
+            return *found;
+        }
+        if (container.getType() == Type::MATRIX) {
+            // a single index reads a whole row
+            const Matrix& matrix = container.as<Matrix>();
+            matrixOffset(matrix, id, Value(0));
+            const double* row = matrix.data() + static_cast<size_t>(id.as<int>()) * matrix.cols();
+            return { std::vector<Value>(row, row + matrix.cols()) };
+        }
+        throw std::runtime_error("expected array or map variable");
+    }
+
+    const Record& recordOf(const Value& value, SymbolId field) {
+        if (value.getType() != Type::STRUCT) {
+            throw std::runtime_error("expected struct before '." + SymbolTable::name(field) + "', got " +
+                typeToString(value.getType()));
+        }
+        return value.as<Record>();
+    }
+
+    void checkLayout(const StructLayout& expected, const StructLayout& actual) {
+        if (expected.getId() != actual.getId()) {
+            throw std::runtime_error("type mismatch. expected " + SymbolTable::name(expected.getName()) +
+                ", got " + SymbolTable::name(actual.getName()));
+        }
+    }
+
+    // a struct value can only replace one of the same struct type
+    void checkSameStruct(const Value& target, const Value& source) {
+        if (target.getType() == Type::STRUCT && source.getType() == Type::STRUCT) {
+            checkLayout(target.as<Record>().getLayout(), source.as<Record>().getLayout());
         }
+        else if (target.getType() == Type::STRUCT_ARRAY && source.getType() == Type::STRUCT_ARRAY) {
+            checkLayout(target.as<StructArray>().getLayout(), source.as<StructArray>().getLayout());
+        }
+    }
+}
+
+Value Interpreter::visit(ArrayAccessNode& node) {
+    Value id = evaluate(*node.getIndex());
+    if (auto& columnExpr = node.getColumn()) {
+        Value column = evaluate(*columnExpr);
+        const Value& container = env.getVariable(node.getSymbol()).value;
+        if (container.getType() != Type::MATRIX) {
+            throw std::runtime_error("expected matrix variable for two indices");
+        }
+        const Matrix& matrix = container.as<Matrix>();
+        return matrix.data()[matrixOffset(matrix, id, column)];
+    }
+    // looked up after the index, which may itself declare or call
+    return elementAt(env.getVariable(node.getSymbol()).value, id);
+}
+
+Value Interpreter::visit(StructDeclNode& node) {
+    env.declareStruct(node.getSymbol(), std::make_shared<const StructLayout>(node.getSymbol(), node.getFields()));
+    return {};
+}
+
+Value Interpreter::visit(StructAllocNode& node) {
+    std::shared_ptr<const StructLayout> layout = env.findStruct(node.getStructName());
+    if (!layout) {
+        throw std::runtime_error("unknown struct type: " + SymbolTable::name(node.getStructName()));
+    }
+
+    if (!node.isArray()) {
+        if (auto& initializer = node.getInitializer()) {
+            Value initial = evaluate(*initializer);
+            if (initial.getType() != Type::STRUCT) {
+                throw std::runtime_error("type mismatch in variable declaration. expected " +
+                    SymbolTable::name(layout->getName()) + ", got " + typeToString(initial.getType()));
+            }
+            checkLayout(*layout, initial.as<Record>().getLayout());
+            return initial;
+        }
+        return Record(layout);
     }
-    throw std::runtime_error("expected array variable");
+
+    int size = -1;
+    if (auto& sizeExpr = node.getSize()) {
+        Value sizeVal = evaluate(*sizeExpr);
+        if (sizeVal.getType() != Type::INT) {
+            throw std::runtime_error("array size must be an integer");
+        }
+        size = sizeVal.get<int>();
+        if (size < 0) {
+            throw std::runtime_error("array size must not be negative");
+        }
+    }
+    if (auto& initializer = node.getInitializer()) {
+        Value initial = evaluate(*initializer);
+        if (!initial.isSequence() || initial.getType() == Type::RANGE) {
+            throw std::runtime_error("struct array initializer must be an array of " + SymbolTable::name(layout->getName()));
+        }
+        if (size >= 0 && initial.length() > static_cast<size_t>(size)) {
+            throw std::runtime_error("array initializer size " + std::to_string(initial.length()) +
+                " exceeds specified size " + std::to_string(size));
+        }
+        if (initial.getType() == Type::STRUCT_ARRAY) {
+            checkLayout(*layout, initial.as<StructArray>().getLayout());
+            return initial;
+        }
+        // an array of records is split into columns
+        StructArray structs(layout, initial.length());
+        for (size_t i = 0; i < initial.length(); ++i) {
+            const Value& element = initial.as<std::vector<Value>>()[i];
+            if (element.getType() != Type::STRUCT) {
+                throw std::runtime_error("struct array initializer must be an array of " + SymbolTable::name(layout->getName()));
+            }
+            structs.setRow(i, element.as<Record>());
+        }
+        return structs;
+    }
+    return StructArray(layout, static_cast<size_t>(size));
+}
+
+Value Interpreter::visit(FieldAccessNode& node) {
+    ASTNode& object = *node.getObject();
+    SymbolId field = node.getField();
+    if (object.getNodeType() == ASTNode::NodeType::Variable) {
+        // read in place, the record is not copied
+        const Record& record = recordOf(env.getVariable(static_cast<VariableNode&>(object).getSymbol()).value, field);
+        return record.field(node.slotIn(record.getLayout()));
+    }
+    if (object.getNodeType() == ASTNode::NodeType::ArrayAccess && !static_cast<ArrayAccessNode&>(object).getColumn()) {
+        auto& access = static_cast<ArrayAccessNode&>(object);
+        Value id = evaluate(*access.getIndex());
+        const Value& container = env.getVariable(access.getSymbol()).value;
+        if (container.getType() == Type::STRUCT_ARRAY) {
+            // straight from the field's column, the element is never gathered
+            const StructArray& structs = container.as<StructArray>();
+            return structs.get(sequenceIndex(container, id), node.slotIn(structs.getLayout()));
+        }
+        Value element = elementAt(container, id);
+        const Record& record = recordOf(element, field);
+        return record.field(node.slotIn(record.getLayout()));
+    }
+    Value value = evaluate(object);
+    const Record& record = recordOf(value, field);
+    return record.field(node.slotIn(record.getLayout()));
+}
+
+Value Interpreter::visit(FieldAssignmentNode& node) {
+    Value exprVal = evaluate(*node.getExpression());
+    ASTNode& object = *node.getObject();
+    SymbolId field = node.getField();
+
+    if (object.getNodeType() == ASTNode::NodeType::Variable) {
+        SymbolId variable = static_cast<VariableNode&>(object).getSymbol();
+        Variable* target = env.findVariableForWrite(variable);
+        if (!target) {
+            throw std::runtime_error("undefined variable: " + SymbolTable::name(variable));
+        }
+        recordOf(target->value, field);
+        Record& record = target->value.recordForWrite();
+        record.setField(node.slotIn(record.getLayout()), exprVal);
+        return exprVal;
+    }
+    if (object.getNodeType() != ASTNode::NodeType::ArrayAccess || static_cast<ArrayAccessNode&>(object).getColumn()) {
+        throw std::runtime_error("invalid assignment target");
+    }
+
+    auto& access = static_cast<ArrayAccessNode&>(object);
+    Value id = evaluate(*access.getIndex());
+    Variable* target = env.findVariable(access.getSymbol());
+    if (!target) {
+        throw std::runtime_error("undefined variable: " + access.getName());
+    }
+    Value& container = target->value;
+    Value* element = nullptr;
+    if (container.getType() == Type::STRUCT_ARRAY) {
+        size_t index = sequenceIndex(container, id);
+        env.findElementForWrite(access.getSymbol(), index);
+        StructArray& structs = container.structArrayForWrite();
+        structs.set(index, node.slotIn(structs.getLayout()), exprVal);
+        return exprVal;
+    }
+    if (container.isSequence()) {
+        size_t index = sequenceIndex(container, id);
+        env.findElementForWrite(access.getSymbol(), index);
+        element = &container.elementsForWrite()[index];
+    }
+    else if (container.getType() == Type::MAP) {
+        env.findVariableForWrite(access.getSymbol());
+        element = container.mapForWrite().find(id);
+        if (!element) {
+            HashMap::checkKey(id);
+            throw std::runtime_error("key not found: " + id.toString());
+        }
+    }
+    else {
+        throw std::runtime_error("expected array or map variable");
+    }
+    recordOf(*element, field);
+    Record& record = element->recordForWrite();
+    record.setField(node.slotIn(record.getLayout()), exprVal);
+    return exprVal;
 }
 
 Value Interpreter::visit(UnaryOpNode& node) {
@@ -67,13 +325,13 @@ Value Interpreter::visit(UnaryOpNode& node) {
         }
         if (val.getType() == Type::INT) {
             auto& varNode = dynamic_cast<VariableNode&>(*operand);
-            auto& var = env.getVariable(varNode.toString());
+            auto& var = *env.findVariableForWrite(varNode.getSymbol());
             var.value = { val.get<int>() + 1 };
             return op == Operator::PreIncrement ? Value{ val.get<int>() + 1 } : val;
         }
         else if (val.getType() == Type::DOUBLE) {
             auto& varNode = dynamic_cast<VariableNode&>(*operand);
-            auto& var = env.getVariable(varNode.toString());
+            auto& var = *env.findVariableForWrite(varNode.getSymbol());
             var.value = { val.get<double>() + 1.0 };
             return op == Operator::PreIncrement ? Value{ val.get<double>() + 1.0 } : val;
         }
@@ -85,13 +343,13 @@ Value Interpreter::visit(UnaryOpNode& node) {
         }
         if (val.getType() == Type::INT) {
             auto& varNode = dynamic_cast<VariableNode&>(*operand);
-            auto& var = env.getVariable(varNode.toString());
+            auto& var = *env.findVariableForWrite(varNode.getSymbol());
             var.value = { val.get<int>() - 1 };
             return op == Operator::PreDecrement ? Value{ val.get<int>() - 1 } : val;
         }
         else if (val.getType() == Type::DOUBLE) {
             auto& varNode = dynamic_cast<VariableNode&>(*operand);
-            auto& var = env.getVariable(varNode.toString());
+            auto& var = *env.findVariableForWrite(varNode.getSymbol());
             var.value = { val.get<double>() - 1.0 };
             return op == Operator::PreDecrement ? Value{ val.get<double>() - 1.0 } : val;
         }
@@ -102,7 +360,7 @@ Value Interpreter::visit(UnaryOpNode& node) {
 }
 
 template<typename T>
-Value performOperation(T left, T right, Operator op) {
+Value performOperation(const T& left, const T& right, Operator op) {
     switch (op) {
     case Operator::Add:
         return Value(left + right);
@@ -123,7 +381,7 @@ Value performOperation(T left, T right, Operator op) {
     case Operator::Divide:
     case Operator::And:
     case Operator::Or:
-        if constexpr (std::is_same_v<T, std::string>) {
+        if constexpr (std::is_same_v<T, SharedString>) {
             throw std::runtime_error("operation not supported for strings");
         }
         else {
@@ -160,8 +418,12 @@ Value Interpreter::visit(BinOpNode& node) {
     Value right = evaluate(*node.getRight());
     Operator op = node.getOperator();
 
+    if (left.isSequence() || right.isSequence()) {
+        return elementWise(left, right, op, scratch);
+    }
+
     if (left.getType() == Type::STRING && right.getType() == Type::STRING) {
-        return performOperation(left.get<std::string>(), right.get<std::string>(), op);
+        return performOperation(left.as<SharedString>(), right.as<SharedString>(), op);
     }
 
     if (left.getType() == Type::INT && right.getType() == Type::INT) {
@@ -183,7 +445,7 @@ Value Interpreter::visit(BinOpNode& node) {
 
 Value Interpreter::visit(AssignmentNode& node) {
     Type declType = node.getDeclType();
-    std::string varName = node.getVarName();
+    SymbolId variable = node.getSymbol();
     Value exprVal = evaluate(*node.getExpression());
     if (declType != Type::VOID) {
         // variable declaration
@@ -191,28 +453,63 @@ Value Interpreter::visit(AssignmentNode& node) {
             throw std::runtime_error("type mismatch in variable declaration. expected " +
                 typeToString(declType) + ", got " + typeToString(exprVal.getType()));
         }
-        env.declareVariable(varName, declType, exprVal);
+        env.declareVariable(variable, declType, exprVal);
         if (declType == Type::ARRAY) {
         }
     }
     else { // assignment to existing variable
-        if (!env.hasVariable(varName)) {
-            throw std::runtime_error("undefined variable: " + varName);
+        // snapshotted below, a single element write only snapshots that element
+        Variable* target = env.findVariable(variable);
+        if (!target) {
+            throw std::runtime_error("undefined variable: " + node.getVarName());
         }
-        Variable& existingVar = env.getVariable(varName);
-        if (node.checkIfArrayAssignment()) {
+        Variable& existingVar = *target;
+        if (auto& columnExpr = node.getColumn()) {
+            Value row = evaluate(*node.getIndex());
+            Value column = evaluate(*columnExpr);
+            if (existingVar.type != Type::MATRIX) {
+                throw std::runtime_error("expected matrix variable for two indices");
+            }
+            if (exprVal.getType() != Type::INT && exprVal.getType() != Type::DOUBLE) {
+                throw std::runtime_error("matrix elements must be numbers, got " + typeToString(exprVal.getType()));
+            }
+            env.findVariableForWrite(variable);
+            Matrix& matrix = existingVar.value.matrixForWrite();
+            size_t offset = matrixOffset(matrix, row, column);
+            matrix.mutableData()[offset] = exprVal.getType() == Type::INT ? exprVal.as<int>() : exprVal.as<double>();
+        }
+        else if (node.checkIfArrayAssignment() && existingVar.type == Type::MAP) {
+            Value key = evaluate(*node.getIndex());
+            HashMap::checkKey(key);
+            env.findVariableForWrite(variable);
+            existingVar.value.mapForWrite()[key] = exprVal;
+        }
+        else if (node.checkIfArrayAssignment() && existingVar.value.getType() == Type::STRUCT_ARRAY) {
+            // scattered into the columns, the array stays struct-of-arrays
+            size_t index = sequenceIndex(existingVar.value, evaluate(*node.getIndex()));
+            if (exprVal.getType() != Type::STRUCT) {
+                throw std::runtime_error("type mismatch in array assignment. cannot assign " +
+                    typeToString(exprVal.getType()) + " to a struct array");
+            }
+            env.findElementForWrite(variable, index);
+            existingVar.value.structArrayForWrite().setRow(index, exprVal.as<Record>());
+        }
+        else if (node.checkIfArrayAssignment()) {
             try {
 				int index = evaluate(*node.getIndex()).get<int>();
-                if (index < 0 || index >= existingVar.value.get<std::vector<Value>>().size()) {
+                if (!existingVar.value.isSequence()) {
+                    throw std::runtime_error("expected array variable");
+                }
+                if (index < 0 || static_cast<size_t>(index) >= existingVar.value.length()) {
 					throw std::runtime_error("array index out of bounds: " + std::to_string(index));
                 }
-                Value& elem = existingVar.value.atIndex(index);
-
-                if (!node.isTypeCompatible(exprVal.getType(), elem.getType())) {
+                Type elementType = existingVar.value.element(index).getType();
+                if (!node.isTypeCompatible(exprVal.getType(), elementType)) {
                     throw std::runtime_error("type mismatch in array assignment. cannot assign"
-                        + typeToString(exprVal.getType()) + "to array of type " + typeToString(elem.getType()));
+                        + typeToString(exprVal.getType()) + "to array of type " + typeToString(elementType));
                 }
-                elem = exprVal;
+                env.findElementForWrite(variable, index);
+                existingVar.value.atIndex(index) = exprVal;
             }
             catch (const std::exception& e) {
 				std::cerr << "error during array assignment: " << e.what() << std::endl;
@@ -224,6 +521,8 @@ Value Interpreter::visit(AssignmentNode& node) {
                 throw std::runtime_error("type mismatch in assignment. cannot assign"
                     + typeToString(exprVal.getType()) + "to variable of type " + typeToString(existingVar.type));
             }
+            checkSameStruct(existingVar.value, exprVal);
+            env.findVariableForWrite(variable);
             existingVar.value = exprVal;
         }
     }
@@ -292,6 +591,7 @@ Value Interpreter::visit(WhileNode& node) {
     auto& condition = node.getCondition();
     auto& body = node.getBody();
     while (evaluate(*condition).toBool()) {
+        safepoint();
         try {
             lastVal = evaluate(*body);
         }
@@ -322,6 +622,7 @@ Value Interpreter::visit(ForNode& node) {
 
         // loop
         while (true) {
+            safepoint();
             // condition check
             if (auto& condition = node.getCondition()) {
                 Value condVal = evaluate(*condition);
@@ -364,40 +665,447 @@ Value Interpreter::visit(ForNode& node) {
     }
 }
 
+Value Interpreter::visit(ForEachNode& node) {
+    // a variable is iterated in place, anything else is evaluated once and
+    // owned by the loop; the Variable itself never moves while we run
+    Value owned;
+    const Value* sequence;
+    ASTNode& sequenceNode = *node.getSequence();
+    if (sequenceNode.getNodeType() == ASTNode::NodeType::Variable) {
+        sequence = &env.getVariable(static_cast<VariableNode&>(sequenceNode).getSymbol()).value;
+    }
+    else {
+        owned = evaluate(sequenceNode);
+        sequence = &owned;
+    }
+    if (sequence->getType() == Type::MAP) {
+        // a map is walked over a snapshot of its keys, so the body may
+        // insert or remove entries
+        owned = mapKeys(sequence->as<Map>().read());
+        sequence = &owned;
+    }
+    if (!sequence->isSequence()) {
+        throw std::runtime_error("foreach expects an array or range, got " + typeToString(sequence->getType()));
+    }
+
+    Value lastVal;
+    Type elemType = node.getElemType();
+    SymbolId symbol = node.getSymbol();
+    ASTNode& body = *node.getBody();
+    // only a body without its own block can declare into the loop scope,
+    // which may rehash it and move the loop variable
+    bool bodyHasScope = body.getNodeType() == ASTNode::NodeType::Block &&
+        static_cast<BlockNode&>(body).shouldCreateScope();
+
+    env.pushScope();
+    try {
+        // a struct has no zero value, the first element is assigned before the body sees it
+        env.declareVariable(symbol, elemType, elemType == Type::STRUCT ? Value() : Value::defaultFor(elemType));
+        Variable* loopVar = env.findVariable(symbol);
+
+        // the loop variable is a copy of each element: assigning to it does not
+        // change the array, and a struct array's row is gathered into a Record.
+        // The length is re-read every round since the body may resize the
+        // array it walks
+        for (size_t i = 0; i < sequence->length(); ++i) {
+            safepoint();
+            Value element = sequence->element(i);
+            if (element.getType() != elemType && !AssignmentNode::isTypeCompatible(element.getType(), elemType)) {
+                throw std::runtime_error("type mismatch in foreach. expected " + typeToString(elemType) +
+                    ", got " + typeToString(element.getType()));
+            }
+            loopVar->value = std::move(element);
+
+            try {
+                lastVal = evaluate(body);
+            }
+            catch (const std::runtime_error& e) {
+                if (std::string(e.what()) == "break encountered") {
+                    break;
+                }
+                else if (std::string(e.what()) != "continue encountered") {
+                    throw;
+                }
+            }
+            if (!bodyHasScope) {
+                loopVar = env.findVariable(symbol);
+            }
+        }
+
+        env.popScope();
+        return lastVal;
+    }
+    catch (...) {
+        env.popScope();
+        throw;
+    }
+}
+
+namespace {
+    // fixed so reductions add up in the same order on every machine, and
+    // enough for work stealing to even out uneven iterations
+    constexpr size_t PARALLEL_FOR_CHUNKS = 64;
+
+    const char* PARALLEL_FOR_SHAPE = "parallel for needs a loop of the form for (int i = a; i < b; i++)";
+
+    bool isVariable(ASTNode& node, SymbolId symbol) {
+        return node.getNodeType() == ASTNode::NodeType::Variable && static_cast<VariableNode&>(node).getSymbol() == symbol;
+    }
+}
+
+Range Interpreter::countingRange(ForNode& loop, SymbolId& counter) {
+    ASTNode* init = loop.getInitialization().get();
+    ASTNode* condition = loop.getCondition().get();
+    ASTNode* increment = loop.getIncrement().get();
+    if (!init || !condition || !increment || init->getNodeType() != ASTNode::NodeType::Assignment ||
+        condition->getNodeType() != ASTNode::NodeType::BinaryOp || increment->getNodeType() != ASTNode::NodeType::UnaryOp) {
+        throw std::runtime_error(PARALLEL_FOR_SHAPE);
+    }
+    auto& start = static_cast<AssignmentNode&>(*init);
+    auto& test = static_cast<BinOpNode&>(*condition);
+    auto& step = static_cast<UnaryOpNode&>(*increment);
+    counter = start.getSymbol();
+    if (start.getDeclType() != Type::INT || !isVariable(*test.getLeft(), counter) || !isVariable(*step.getOperand(), counter)) {
+        throw std::runtime_error(PARALLEL_FOR_SHAPE);
+    }
+
+    bool up = step.getOperator() == Operator::PreIncrement || step.getOperator() == Operator::PostIncrement;
+    bool down = step.getOperator() == Operator::PreDecrement || step.getOperator() == Operator::PostDecrement;
+    Operator op = test.getOperator();
+    if (!(up && (op == Operator::Less || op == Operator::LessEqual)) &&
+        !(down && (op == Operator::Greater || op == Operator::GreaterEqual))) {
+        throw std::runtime_error(PARALLEL_FOR_SHAPE);
+    }
+
+    // both ends are evaluated once, the bound as the first test would see it
+    Value first;
+    Value bound;
+    env.pushScope();
+    try {
+        evaluate(start);
+        first = env.getVariable(counter).value;
+        bound = evaluate(*test.getRight());
+        env.popScope();
+    }
+    catch (...) {
+        env.popScope();
+        throw;
+    }
+    if (bound.getType() != Type::INT) {
+        throw std::runtime_error("parallel for bound must be an integer");
+    }
+
+    int64_t end = bound.as<int>();
+    if (op == Operator::LessEqual) end++;
+    if (op == Operator::GreaterEqual) end--;
+    if (end > std::numeric_limits<int>::max() || end < std::numeric_limits<int>::min()) {
+        throw std::runtime_error("parallel for bound out of range");
+    }
+    return Range{ first.as<int>(), static_cast<int>(end), up ? 1 : -1 };
+}
+
+Value Interpreter::visit(ParallelForNode& node) {
+    ForNode& loop = node.getLoop();
+    SymbolId counter = NO_SYMBOL;
+    Range space = countingRange(loop, counter);
+    ASTNode& body = *loop.getBody();
+    const std::vector<SymbolId>& reductions = node.getReductions();
+
+    EffectAnalyzer analyzer(env, [this](FunctionNode& function) { prepareBody(function); });
+    std::vector<SymbolId> sharedArrays = analyzer.analyze(body, counter, reductions);
+
+    std::vector<Type> reductionTypes;
+    for (SymbolId symbol : reductions) {
+        Variable* var = env.findVariable(symbol);
+        if (!var) {
+            throw std::runtime_error("undefined variable: " + SymbolTable::name(symbol));
+        }
+        if (var->type != Type::INT && var->type != Type::DOUBLE) {
+            throw std::runtime_error("reduction variable '" + SymbolTable::name(symbol) + "' must be int or double");
+        }
+        reductionTypes.push_back(var->type);
+    }
+
+    // the written arrays are snapshotted and made writable in place here,
+    // so the workers only ever store into elements
+    for (SymbolId array : sharedArrays) {
+        Variable* var = env.findVariableForWrite(array);
+        if (!var) {
+            throw std::runtime_error("undefined variable: " + SymbolTable::name(array));
+        }
+        Type type = var->value.getType();
+        if (type == Type::RANGE || type == Type::ARRAY) {
+            var->value.elementsForWrite();
+        }
+        else if (type == Type::STRUCT_ARRAY) {
+            var->value.structArrayForWrite().unshare();
+        }
+        else {
+            throw std::runtime_error("parallel for can only write elements of arrays, '" + SymbolTable::name(array) +
+                "' is " + typeToString(type));
+        }
+    }
+
+    size_t iterations = space.size();
+    size_t chunks = std::min(iterations, PARALLEL_FOR_CHUNKS);
+    std::vector<Value> partials(chunks * reductions.size());
+
+    ThreadPool::shared().parallelFor(chunks, [&](size_t chunk) {
+        // reads fall through to our environment, which nobody writes to
+        // until the loop is done
+        Environment local(env);
+        Interpreter worker(local);
+        worker.setInterruptFlag(interrupt);
+        for (size_t r = 0; r < reductions.size(); ++r) {
+            local.declareVariable(reductions[r], reductionTypes[r], Value::defaultFor(reductionTypes[r]));
+        }
+
+        size_t end = iterations * (chunk + 1) / chunks;
+        for (size_t k = iterations * chunk / chunks; k < end; ++k) {
+            worker.safepoint();
+            // each iteration has a scope of its own holding its counter
+            local.pushScope();
+            try {
+                local.declareVariable(counter, Type::INT, Value(space.at(k)));
+                worker.evaluate(body);
+            }
+            catch (const std::runtime_error& e) {
+                if (std::string(e.what()) != "continue encountered") {
+                    local.popScope();
+                    throw;
+                }
+            }
+            local.popScope();
+            worker.releaseTemporaries();
+        }
+
+        for (size_t r = 0; r < reductions.size(); ++r) {
+            partials[chunk * reductions.size() + r] = local.getVariable(reductions[r]).value;
+        }
+    });
+
+    // partial sums are added in chunk order, never in finishing order
+    for (size_t r = 0; r < reductions.size(); ++r) {
+        Variable& total = *env.findVariableForWrite(reductions[r]);
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            const Value& partial = partials[chunk * reductions.size() + r];
+            if (reductionTypes[r] == Type::INT) {
+                total.value = performOperation(total.value.as<int>(), partial.as<int>(), Operator::Add);
+            }
+            else {
+                total.value = performOperation(total.value.as<double>(), partial.as<double>(), Operator::Add);
+            }
+        }
+    }
+    return {};
+}
+
+Value Interpreter::evaluateScript(std::vector<std::unique_ptr<ASTNode>>& statements) {
+    Value result;
+    if (ThreadPool::shared().concurrency() == 1) {
+        for (auto& statement : statements) {
+            result = evaluate(*statement);
+            releaseTemporaries();
+        }
+        return result;
+    }
+
+    // statements are analyzed up to the next barrier only: what a call does
+    // depends on the functions declared by the time it runs
+    DependencyAnalyzer analyzer(env, [this](FunctionNode& function) { prepareBody(function); });
+    size_t next = 0;
+    while (next < statements.size()) {
+        std::vector<StatementEffects> segment;
+        size_t barrier = next;
+        for (; barrier < statements.size(); ++barrier) {
+            StatementEffects effects = analyzer.analyze(*statements[barrier]);
+            if (effects.barrier) {
+                break;
+            }
+            segment.push_back(std::move(effects));
+        }
+        if (!segment.empty()) {
+            result = evaluateWaves(statements, next, segment);
+        }
+        if (barrier < statements.size()) {
+            result = evaluate(*statements[barrier]);
+            releaseTemporaries();
+        }
+        next = barrier + 1;
+    }
+    lastResult = result;
+    return result;
+}
+
+Value Interpreter::evaluateWaves(std::vector<std::unique_ptr<ASTNode>>& statements, size_t first,
+    const std::vector<StatementEffects>& effects) {
+    std::vector<size_t> waveOf = DependencyAnalyzer::waves(effects);
+    std::vector<std::vector<size_t>> waves(*std::max_element(waveOf.begin(), waveOf.end()) + 1);
+    for (size_t i = 0; i < waveOf.size(); ++i) {
+        waves[waveOf[i]].push_back(i);
+    }
+
+    // the earliest failing statement is the one reported, as if run in order
+    size_t failed = effects.size();
+    std::exception_ptr failure;
+    auto fail = [&](size_t i, std::exception_ptr error) {
+        if (i < failed) {
+            failed = i;
+            failure = error;
+        }
+    };
+    Value result;
+
+    for (std::vector<size_t>& wave : waves) {
+        // statements after a failed one would never have run
+        wave.erase(std::remove_if(wave.begin(), wave.end(), [failed](size_t i) { return i > failed; }), wave.end());
+        if (wave.empty()) {
+            continue;
+        }
+        if (wave.size() == 1) {
+            size_t i = wave.front();
+            try {
+                Value value = evaluate(*statements[first + i]);
+                if (i + 1 == effects.size()) {
+                    result = std::move(value);
+                }
+            }
+            catch (const std::exception&) {
+                fail(i, std::current_exception());
+            }
+            releaseTemporaries();
+            continue;
+        }
+
+        // the globals the wave changes are snapshotted here, each statement
+        // then writes its own ones in place
+        for (size_t i : wave) {
+            for (SymbolId symbol : effects[i].writes) {
+                env.findVariableForWrite(symbol);
+            }
+        }
+
+        std::vector<std::unique_ptr<Environment>> locals(wave.size());
+        std::vector<Value> values(wave.size());
+        std::vector<std::exception_ptr> errors(wave.size());
+        ThreadPool::shared().parallelFor(wave.size(), [&](size_t k) {
+            // declarations stay in the statement's own environment until the
+            // whole wave is done
+            locals[k] = std::make_unique<Environment>(env);
+            Interpreter worker(*locals[k]);
+            worker.setInterruptFlag(interrupt);
+            try {
+                values[k] = worker.evaluate(*statements[first + wave[k]]);
+            }
+            catch (const std::exception&) {
+                errors[k] = std::current_exception();
+            }
+        });
+
+        for (size_t k = 0; k < wave.size(); ++k) {
+            size_t i = wave[k];
+            if (errors[k]) {
+                fail(i, errors[k]);
+                continue;
+            }
+            try {
+                for (SymbolId symbol : effects[i].declares) {
+                    if (Variable* var = locals[k]->findOwnGlobal(symbol)) {
+                        env.declareVariable(symbol, var->type, std::move(var->value));
+                    }
+                }
+            }
+            catch (const std::exception&) {
+                fail(i, std::current_exception());
+            }
+            if (i + 1 == effects.size()) {
+                result = std::move(values[k]);
+            }
+        }
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return result;
+}
+
 Value Interpreter::visit(FunctionNode& node) {
     // register the function in the environment
-    env.declareFunction(node.getName(), &node);
+    env.declareFunction(node.getSymbol(), &node);
     return {};
 }
 
-Value Interpreter::visit(CallNode& node) {
-    const std::string& funcName = node.getFuncName();
-    FunctionNode* funcDef = env.getFunction(funcName);
-    const auto& params = funcDef->getParameters();
+Value Interpreter::callBuiltin(const Builtin& builtin, CallNode& node) {
     const auto& argsNodes = node.getArguments();
+    if (argsNodes.size() < builtin.minArgs || argsNodes.size() > builtin.maxArgs()) {
+        std::string expected = std::to_string(builtin.minArgs);
+        if (builtin.maxArgs() != builtin.minArgs) {
+            expected += " to " + std::to_string(builtin.maxArgs());
+        }
+        throw std::runtime_error(std::string(builtin.name) + " expects " + expected +
+            " arguments, got " + std::to_string(argsNodes.size()));
+    }
 
+    // variables are handed over by address so a long string or array is not
+    // copied just to be read, everything else is evaluated into the arena
+    ScratchArena::Frame frame(scratch);
+    std::pmr::vector<Value> temporaries(&scratch);
+    temporaries.reserve(argsNodes.size());
+    BuiltinArgs args(&scratch);
+    args.reserve(argsNodes.size());
+    for (const auto& arg : argsNodes) {
+        if (arg->getNodeType() == ASTNode::NodeType::Variable) {
+            SymbolId symbol = static_cast<VariableNode&>(*arg).getSymbol();
+            if (args.empty() && builtin.writesFirstArgument) {
+                Variable* target = env.findVariableForWrite(symbol);
+                if (!target) {
+                    throw std::runtime_error("undefined variable: " + SymbolTable::name(symbol));
+                }
+                args.push_back(&target->value);
+            }
+            else {
+                args.push_back(&env.getVariable(symbol).value);
+            }
+        }
+        else {
+            temporaries.push_back(evaluate(*arg));
+            args.push_back(&temporaries.back());
+        }
+    }
+    builtin.checkArguments(args);
+    return builtin.fn(*this, args);
+}
 
-    std::vector<Value> evalArgs;
+// builds the body of a pre-parsed function on its first call
+void Interpreter::prepareBody(FunctionNode& function) {
+    if (!function.hasDeferredBody()) {
+        return;
+    }
     try {
-        // pre-allocate space to avoid reallocation
-        evalArgs.reserve(argsNodes.size());
-
-        // evaluate all arguments before creating new scope
-        for (const auto& arg : argsNodes) {
-            evalArgs.push_back(evaluate(*arg));
-        }
+        Parser bodyParser;
+        function.setBody(bodyParser.parseFunctionBody(function.getDeferredBody()));
+    }
+    catch (const std::exception& e) {
+        throw std::runtime_error("in body of function '" + function.getName() + "': " + e.what());
+    }
+}
 
+Value Interpreter::invoke(FunctionNode& function, std::pmr::vector<Value>& args) {
+    safepoint();
+    const auto& params = function.getParameters();
+    bool scopePushed = false;
+    try {
         env.pushScope();
+        scopePushed = true;
 
         // bind parameters in new scope
-        if (!params.empty()) {
-            for (size_t i = 0; i < params.size(); ++i) {
-                env.declareVariable(params[i].first, params[i].second, evalArgs[i]);
-            }
+        for (size_t i = 0; i < params.size(); ++i) {
+            env.declareVariable(params[i].first, params[i].second, std::move(args[i]));
         }
 
         // execute function body
-        Value result = evaluate(*funcDef->getBody());
+        Value result = evaluate(*function.getBody());
         env.popScope();
         return result;
     }
@@ -406,13 +1114,51 @@ Value Interpreter::visit(CallNode& node) {
         return e.value;
     }
     catch (...) {
-        if (!evalArgs.empty()) {
+        if (scopePushed) {
             env.popScope();
         }
         throw;
     }
 }
 
+Value Interpreter::callFunction(SymbolId symbol, std::pmr::vector<Value>& args) {
+    FunctionNode* function = env.getFunction(symbol);
+    prepareBody(*function);
+    if (args.size() != function->getParameters().size()) {
+        env.validateFunctionCall(function->getName(), args.size());
+    }
+    return invoke(*function, args);
+}
+
+Value Interpreter::visit(CallNode& node) {
+    FunctionNode* funcDef = env.findFunction(node.getSymbol());
+    if (!funcDef) {
+        // script functions shadow builtins of the same name
+        if (const Builtin* builtin = findBuiltin(node.getSymbol())) {
+            return callBuiltin(*builtin, node);
+        }
+        funcDef = env.getFunction(node.getSymbol());
+    }
+    prepareBody(*funcDef);
+    const auto& argsNodes = node.getArguments();
+    if (argsNodes.size() != funcDef->getParameters().size()) {
+        env.validateFunctionCall(funcDef->getName(), argsNodes.size());
+    }
+
+    // argument vectors live in the scratch arena and are given back when
+    // the call returns, the values themselves move into the callee's scope
+    ScratchArena::Frame frame(scratch);
+    std::pmr::vector<Value> evalArgs(&scratch);
+    // pre-allocate space to avoid reallocation
+    evalArgs.reserve(argsNodes.size());
+
+    // evaluate all arguments before creating new scope
+    for (const auto& arg : argsNodes) {
+        evalArgs.push_back(evaluate(*arg));
+    }
+    return invoke(*funcDef, evalArgs);
+}
+
 Value Interpreter::visit(ReturnNode& node) {
     Value returnValue;
     if (node.getExpression()) {
@@ -2,12 +2,18 @@
 #define SEASHELLS_INTERPRETER_H
 
 #include "ASTVisitor.h"
+#include "Builtins.h"
+#include "DependencyAnalyzer.h"
 #include "../environment/Environment.h"
+#include "../environment/ScratchArena.h"
+#include <atomic>
 
 class Interpreter : public ASTVisitor {
 private:
     Environment& env;
     Value lastResult;
+    ScratchArena scratch; // temporaries of the current top-level statement
+    const std::atomic<bool>* interrupt = nullptr; // raised by another thread to stop us
 
     class ReturnException : public std::exception {
     public:
@@ -16,6 +22,25 @@ private:
         explicit ReturnException(Value&& val) : value(std::move(val)) {}
     };
 
+    // checked at every loop iteration and call, so a raised interrupt flag
+    // stops even a runaway script promptly
+    void safepoint() const {
+        if (interrupt && interrupt->load(std::memory_order_relaxed)) {
+            throw std::runtime_error("interrupted");
+        }
+    }
+
+    Value callBuiltin(const Builtin& builtin, CallNode& node);
+    void prepareBody(FunctionNode& function);
+    // runs function with args bound to its parameters, args are moved from
+    Value invoke(FunctionNode& function, std::pmr::vector<Value>& args);
+    // iterations of a parallel for's counting loop, counter is set to its variable
+    Range countingRange(ForNode& loop, SymbolId& counter);
+    // runs statements[first..] in waves of statements that don't conflict,
+    // effects holds one entry per statement; the last one's value is returned
+    Value evaluateWaves(std::vector<std::unique_ptr<ASTNode>>& statements, size_t first,
+        const std::vector<StatementEffects>& effects);
+
 public:
     explicit Interpreter(Environment& env) : env(env) {}
 
@@ -24,20 +49,47 @@ public:
         return lastResult;
     }
 
+    // top-level statements of a script in order, as if run one by one;
+    // statements that don't touch each other's globals run at the same time
+    Value evaluateScript(std::vector<std::unique_ptr<ASTNode>>& statements);
+
     std::string getLastResult() const {
         return lastResult.toString();
     }
 
+    // evaluation fails with "interrupted" at the next safepoint once flag is set
+    void setInterruptFlag(const std::atomic<bool>* flag) {
+        interrupt = flag;
+    }
+
     Environment& getEnvironment() {
         return env;
     }
 
+    // calls a script function by name, for builtins taking a callback
+    Value callFunction(SymbolId symbol, std::pmr::vector<Value>& args);
+
+    // for builtins that need short-lived buffers
+    ScratchArena& getScratch() {
+        return scratch;
+    }
+
+    // frees every temporary of the statement that just finished
+    void releaseTemporaries() {
+        scratch.release();
+    }
+
     Value visit(BreakNode& node) override;
     Value visit(ContinueNode& node) override;
     Value visit(LiteralNode& node) override;
     Value visit(VariableNode& node) override;
     Value visit(ArrayNode& node) override;
+    Value visit(ArrayAllocNode& node) override;
     Value visit(ArrayAccessNode& node) override;
+    Value visit(StructDeclNode& node) override;
+    Value visit(StructAllocNode& node) override;
+    Value visit(FieldAccessNode& node) override;
+    Value visit(FieldAssignmentNode& node) override;
     Value visit(UnaryOpNode& node) override;
     Value visit(BinOpNode& node) override;
     Value visit(AssignmentNode& node) override;
@@ -45,6 +97,8 @@ public:
     Value visit(IfNode& node) override;
     Value visit(WhileNode& node) override;
     Value visit(ForNode& node) override;
+    Value visit(ForEachNode& node) override;
+    Value visit(ParallelForNode& node) override;
     Value visit(FunctionNode& node) override;
     Value visit(ReturnNode& node) override;
     Value visit(CallNode& node) override;
@@ -0,0 +1,27 @@
+#ifndef SEASHELLS_ARRAY_H
+#define SEASHELLS_ARRAY_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class Value;
+
+// copy-on-write handle to an array's elements: copying an array value only
+// bumps a refcount, the elements are cloned on the first write through a
+// shared handle
+class Array {
+public:
+    Array() = default;
+    explicit Array(std::vector<Value> elements);
+
+    const std::vector<Value>& read() const;
+    std::vector<Value>& write();
+
+    size_t size() const;
+
+private:
+    std::shared_ptr<std::vector<Value>> elements; // null until the first write
+};
+
+#endif //SEASHELLS_ARRAY_H
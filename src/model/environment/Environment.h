@@ -4,6 +4,8 @@
 #include "Scope.h"
 #include "../ast/ASTNode.h"
 #include <unordered_map>
+#include <unordered_set>
+#include <deque>
 #include <memory>
 #include <iostream>
 #include <iomanip>
@@ -12,8 +14,134 @@
 class Environment {
 private:
     static constexpr size_t MAX_NAME_LENGTH = 256;
+    static constexpr size_t MAX_UNDO_STEPS = 32;
+    static constexpr size_t WHOLE_VARIABLE = static_cast<size_t>(-1);
     std::vector<std::unique_ptr<Scope>> scopeStack;
-    std::unordered_map<std::string, std::unique_ptr<FunctionNode>> functions;
+    std::unordered_map<SymbolId, std::unique_ptr<FunctionNode>> functions;
+    std::unordered_map<SymbolId, std::shared_ptr<const StructLayout>> structs;
+
+    // copy-on-write view of the globals: a snapshot only holds the previous
+    // version of each global an input touched, everything else stays shared
+    // with the live environment, so commit and rollback cost O(changed).
+    // A write to a single array element only records that element
+    struct Snapshot {
+        struct VariableVersion {
+            SymbolId symbol;
+            bool existed;      // false if the input declared it
+            Variable previous; // the element's previous value in previous.value if element is set
+            size_t element = WHOLE_VARIABLE;
+        };
+        struct FunctionVersion {
+            SymbolId symbol;
+            std::unique_ptr<FunctionNode> previous; // null if the input declared it
+        };
+        struct StructVersion {
+            SymbolId symbol;
+            std::shared_ptr<const StructLayout> previous; // null if the input declared it
+        };
+
+        std::vector<VariableVersion> variables;
+        std::vector<FunctionVersion> functions;
+        std::vector<StructVersion> structs;
+        std::unordered_set<SymbolId> touchedVariables;
+        std::unordered_map<SymbolId, size_t> touchedElements; // element versions per array
+        std::unordered_set<SymbolId> touchedFunctions;
+        std::unordered_set<SymbolId> touchedStructs;
+    };
+
+    // environment a worker of a parallel loop was started from; anything not
+    // declared here is looked up there, and only ever read while workers run
+    Environment* parent = nullptr;
+
+    bool inTransaction = false;
+    Snapshot current;
+    std::deque<Snapshot> history; // committed inputs, most recent last
+
+    Scope& globalScope() {
+        return *scopeStack.front();
+    }
+
+    // records the pre-input version of a global the first time it changes
+    void touchGlobal(SymbolId symbol, bool existed) {
+        if (!inTransaction || !current.touchedVariables.insert(symbol).second) {
+            return;
+        }
+        Variable previous = existed ? *globalScope().findVariable(symbol) : Variable{};
+        current.variables.push_back({ symbol, existed, std::move(previous) });
+    }
+
+    // records the pre-input version of element index of a global array; an
+    // array that had a quarter of its elements recorded is recorded whole
+    // instead, which still restores correctly as versions are undone newest first
+    void touchElement(SymbolId symbol, Variable& global, size_t index) {
+        if (!inTransaction || current.touchedVariables.count(symbol)) {
+            return;
+        }
+        Type type = global.value.getType();
+        size_t length = global.value.length();
+        if ((type != Type::ARRAY && type != Type::STRUCT_ARRAY) || index >= length ||
+            ++current.touchedElements[symbol] > length / 4) {
+            touchGlobal(symbol, true);
+            return;
+        }
+        current.variables.push_back({ symbol, true, Variable{ global.type, global.value.element(index) }, index });
+    }
+
+    void touchFunction(SymbolId symbol) {
+        if (!inTransaction || !current.touchedFunctions.insert(symbol).second) {
+            return;
+        }
+        auto it = functions.find(symbol);
+        current.functions.push_back({ symbol, it != functions.end() ? std::move(it->second) : nullptr });
+    }
+
+    void touchStruct(SymbolId symbol) {
+        if (!inTransaction || !current.touchedStructs.insert(symbol).second) {
+            return;
+        }
+        auto it = structs.find(symbol);
+        current.structs.push_back({ symbol, it != structs.end() ? it->second : nullptr });
+    }
+
+    // puts every recorded global back to its version from before the input
+    void restore(Snapshot& snapshot) {
+        while (scopeStack.size() > 1) {
+            scopeStack.pop_back();
+        }
+        for (auto it = snapshot.variables.rbegin(); it != snapshot.variables.rend(); ++it) {
+            if (it->element != WHOLE_VARIABLE) {
+                Value& array = globalScope().findVariable(it->symbol)->value;
+                if (array.getType() == Type::STRUCT_ARRAY) {
+                    array.structArrayForWrite().setRow(it->element, it->previous.value.as<Record>());
+                }
+                else {
+                    array.elementsForWrite()[it->element] = std::move(it->previous.value);
+                }
+            }
+            else if (it->existed) {
+                *globalScope().findVariable(it->symbol) = std::move(it->previous);
+            }
+            else {
+                globalScope().removeVariable(it->symbol);
+            }
+        }
+        for (auto it = snapshot.functions.rbegin(); it != snapshot.functions.rend(); ++it) {
+            if (it->previous) {
+                functions[it->symbol] = std::move(it->previous);
+            }
+            else {
+                functions.erase(it->symbol);
+            }
+        }
+        for (auto it = snapshot.structs.rbegin(); it != snapshot.structs.rend(); ++it) {
+            if (it->previous) {
+                structs[it->symbol] = std::move(it->previous);
+            }
+            else {
+                structs.erase(it->symbol);
+            }
+        }
+    }
 
     bool isValidIdentifier(const std::string& name, bool isFunction = false) const {
         if (name.empty()) {
@@ -33,6 +161,56 @@ public:
         pushScope(); // create global scope
     }
 
+    // private environment for a worker thread, chained to parent
+    explicit Environment(Environment& parent) : parent(&parent) {
+        pushScope();
+    }
+
+    // independent copy of the globals, functions and structs for a background
+    // job. Arrays, maps, matrices and struct arrays are copy-on-write, so the
+    // globals only cost a refcount each until the job writes them; function
+    // ASTs are cloned, the job may prepare their bodies while we run others
+    std::unique_ptr<Environment> fork() const {
+        auto copy = std::make_unique<Environment>();
+        *copy->scopeStack.front() = *scopeStack.front();
+        for (const auto& [symbol, function] : functions) {
+            copy->functions[symbol].reset(static_cast<FunctionNode*>(function->clone().release()));
+        }
+        copy->structs = structs;
+        return copy;
+    }
+
+    // applies the globals, functions and structs a fork changed in its
+    // transaction to this environment, replacing whatever is here now
+    void mergeChanges(Environment& fork) {
+        std::unordered_set<SymbolId> merged;
+        for (const auto& version : fork.current.variables) {
+            if (!merged.insert(version.symbol).second) {
+                continue;
+            }
+            Variable* changed = fork.globalScope().findVariable(version.symbol);
+            if (!changed) {
+                continue;
+            }
+            if (Variable* mine = globalScope().findVariable(version.symbol)) {
+                touchGlobal(version.symbol, true);
+                *mine = *changed;
+            }
+            else {
+                touchGlobal(version.symbol, false);
+                globalScope().declareVariable(version.symbol, changed->type, changed->value);
+            }
+        }
+        for (const auto& version : fork.current.functions) {
+            touchFunction(version.symbol);
+            functions[version.symbol] = std::move(fork.functions[version.symbol]);
+        }
+        for (const auto& version : fork.current.structs) {
+            touchStruct(version.symbol);
+            structs[version.symbol] = fork.structs[version.symbol];
+        }
+    }
+
     void pushScope() {
         try {
             scopeStack.push_back(std::make_unique<Scope>());
@@ -54,40 +232,138 @@ public:
         return scopeStack.size() == 1;
     }
 
-    void declareVariable(const std::string& name, Type type, const Value& value) {
+    // starts recording changes to globals for the next input
+    void beginTransaction() {
+        current = Snapshot{};
+        inTransaction = true;
+    }
+
+    // keeps the input's changes, its snapshot becomes the next undo step
+    void commit() {
+        inTransaction = false;
+        if (current.variables.empty() && current.functions.empty() && current.structs.empty()) {
+            return;
+        }
+        history.push_back(std::move(current));
+        if (history.size() > MAX_UNDO_STEPS) {
+            history.pop_front();
+        }
+        current = Snapshot{};
+    }
+
+    // discards every change made since beginTransaction()
+    void rollback() {
+        inTransaction = false;
+        restore(current);
+        current = Snapshot{};
+    }
+
+    // reverts the most recently committed input, false if there is none
+    bool undo() {
+        if (history.empty()) {
+            return false;
+        }
+        restore(history.back());
+        history.pop_back();
+        return true;
+    }
+
+    void declareVariable(SymbolId symbol, Type type, Value value) {
         try {
-            if (name.empty()) {
+            if (symbol == NO_SYMBOL) {
                 throw std::runtime_error("Empty variable name");
             }
-            // copy of the name to ensure string stability
-            std::string nameCopy = name;
-            scopeStack.back()->declareVariable(nameCopy, type, value);
+            if (isInGlobalScope()) {
+                if (globalScope().hasVariable(symbol)) {
+                    throw std::runtime_error("Variable already declared: " + SymbolTable::name(symbol));
+                }
+                touchGlobal(symbol, false);
+            }
+            scopeStack.back()->declareVariable(symbol, type, std::move(value));
         }
         catch (const std::bad_alloc& e) {
-            std::cerr << "Memory allocation failed in declareVariable() for " << name << " : " << e.what() << std::endl;
+            std::cerr << "Memory allocation failed in declareVariable() for " << SymbolTable::name(symbol) << " : " << e.what() << std::endl;
             throw;
         }
     }
 
-    Variable& getVariable(const std::string& name) {
+    void declareVariable(const std::string& name, Type type, Value value) {
+        if (name.empty()) {
+            throw std::runtime_error("Empty variable name");
+        }
+        declareVariable(SymbolTable::intern(name), type, std::move(value));
+    }
+
+    // innermost declaration of symbol, nullptr if it is not declared anywhere
+    Variable* findVariable(SymbolId symbol) {
         for (auto it = scopeStack.rbegin(); it != scopeStack.rend(); ++it) {
-            if ((*it)->hasVariable(name)) {
-                return (*it)->getVariable(name);
+            if (Variable* var = (*it)->findVariable(symbol)) {
+                return var;
             }
         }
-        throw std::runtime_error("Variable '" + name + "' not found in any scope");
+        return parent ? parent->findVariable(symbol) : nullptr;
     }
 
-    bool hasVariable(const std::string& name) const {
+    // global declared in this environment itself, the parent is not searched
+    Variable* findOwnGlobal(SymbolId symbol) {
+        return globalScope().findVariable(symbol);
+    }
+
+    // lookup for a variable about to be modified, globals are snapshotted
+    // before their first change in a transaction
+    Variable* findVariableForWrite(SymbolId symbol) {
+        for (auto it = scopeStack.rbegin(); it != scopeStack.rend(); ++it) {
+            if (Variable* var = (*it)->findVariable(symbol)) {
+                if (inTransaction && it->get() == scopeStack.front().get()) {
+                    touchGlobal(symbol, true);
+                }
+                return var;
+            }
+        }
+        // the parent's globals were snapshotted before the workers started
+        return parent ? parent->findVariable(symbol) : nullptr;
+    }
+
+    // lookup for a variable about to have element index written; of a global
+    // only that element is snapshotted
+    Variable* findElementForWrite(SymbolId symbol, size_t index) {
+        for (auto it = scopeStack.rbegin(); it != scopeStack.rend(); ++it) {
+            if (Variable* var = (*it)->findVariable(symbol)) {
+                if (inTransaction && it->get() == scopeStack.front().get()) {
+                    touchElement(symbol, *var, index);
+                }
+                return var;
+            }
+        }
+        return parent ? parent->findVariable(symbol) : nullptr;
+    }
+
+    Variable& getVariable(SymbolId symbol) {
+        if (Variable* var = findVariable(symbol)) {
+            return *var;
+        }
+        throw std::runtime_error("Variable '" + SymbolTable::name(symbol) + "' not found in any scope");
+    }
+
+    Variable& getVariable(const std::string& name) {
+        return getVariable(SymbolTable::intern(name));
+    }
+
+    bool hasVariable(SymbolId symbol) const {
         for (auto it = scopeStack.rbegin(); it != scopeStack.rend(); ++it) {
-            if ((*it)->hasVariable(name)) {
+            if ((*it)->hasVariable(symbol)) {
                 return true;
             }
         }
-        return false;
+        return parent && parent->hasVariable(symbol);
     }
 
-    void declareFunction(const std::string& name, const FunctionNode* function) {
+    bool hasVariable(const std::string& name) const {
+        return hasVariable(SymbolTable::intern(name));
+    }
+
+    void declareFunction(SymbolId symbol, const FunctionNode* function) {
+        const std::string& name = SymbolTable::name(symbol);
         try {
             if (!function) {
                 throw std::runtime_error("Attempting to declare null function pointer for: " + name);
@@ -99,8 +375,9 @@ public:
             auto funcCopy = std::unique_ptr<FunctionNode>(
                 static_cast<FunctionNode*>(function->clone().release())
             );
-            functions[name] = std::move(funcCopy);
-            std::cerr << "Declaring function '" << getFunction(name)->getName() << "' with " << getFunction(name)->getParameters().size() << " parameters" << std::endl;
+            touchFunction(symbol);
+            functions[symbol] = std::move(funcCopy);
+            std::cerr << "Declaring function '" << getFunction(symbol)->getName() << "' with " << getFunction(symbol)->getParameters().size() << " parameters" << std::endl;
         }
         catch (const std::bad_alloc& e) {
             std::cerr << "Memory allocation failed in declareFunction() for " << name << " : " << e.what() << std::endl;
@@ -108,16 +385,48 @@ public:
         }
     }
 
-    FunctionNode* getFunction(const std::string& name) {
-        auto it = functions.find(name);
-        if (it == functions.end()) {
-            throw std::runtime_error("Function not found: " + name);
+    FunctionNode* getFunction(SymbolId symbol) {
+        if (FunctionNode* function = findFunction(symbol)) {
+            return function;  // raw pointer to our owned copy
         }
-        return it->second.get();  // return raw pointer to our owned copy
+        throw std::runtime_error("Function not found: " + SymbolTable::name(symbol));
+    }
+
+    // null if no such function is declared
+    FunctionNode* findFunction(SymbolId symbol) {
+        auto it = functions.find(symbol);
+        if (it != functions.end()) {
+            return it->second.get();
+        }
+        return parent ? parent->findFunction(symbol) : nullptr;
+    }
+
+    FunctionNode* getFunction(const std::string& name) {
+        return getFunction(SymbolTable::intern(name));
+    }
+
+    bool hasFunction(SymbolId symbol) const {
+        return functions.find(symbol) != functions.end() || (parent && parent->hasFunction(symbol));
     }
 
     bool hasFunction(const std::string& name) const {
-        return functions.find(name) != functions.end();
+        return hasFunction(SymbolTable::intern(name));
+    }
+
+    // a redeclared struct gets a new layout, values built from the old one
+    // keep it alive and stay as they are
+    void declareStruct(SymbolId symbol, std::shared_ptr<const StructLayout> layout) {
+        touchStruct(symbol);
+        structs[symbol] = std::move(layout);
+    }
+
+    // null if no such struct is declared
+    std::shared_ptr<const StructLayout> findStruct(SymbolId symbol) const {
+        auto it = structs.find(symbol);
+        if (it != structs.end()) {
+            return it->second;
+        }
+        return parent ? parent->findStruct(symbol) : nullptr;
     }
 
     void validateFunctionCall(const std::string& name, size_t argCount) {
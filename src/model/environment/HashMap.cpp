@@ -0,0 +1,238 @@
+#include "HashMap.h"
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEASHELL_HAVE_SSE2 1
+#endif
+
+namespace {
+    constexpr size_t MIN_GROUPS = 1;
+
+    // bit i set where group byte i equals value
+    unsigned matchByte(const int8_t* group, int8_t value) {
+#ifdef SEASHELL_HAVE_SSE2
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value))));
+#else
+        unsigned mask = 0;
+        for (size_t i = 0; i < HashMap::GROUP_SIZE; ++i) {
+            mask |= static_cast<unsigned>(group[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // bit i set where group byte i is empty or deleted, both have the top bit set
+    unsigned matchFree(const int8_t* group) {
+#ifdef SEASHELL_HAVE_SSE2
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<unsigned>(_mm_movemask_epi8(bytes));
+#else
+        unsigned mask = 0;
+        for (size_t i = 0; i < HashMap::GROUP_SIZE; ++i) {
+            mask |= static_cast<unsigned>(group[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+    unsigned lowestBit(unsigned mask) {
+        unsigned bit = 0;
+        while (!(mask & (1u << bit))) bit++;
+        return bit;
+    }
+
+    uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    int8_t controlByte(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+    size_t groupHash(size_t hash) { return hash >> 7; }
+
+    bool sameKey(const Value& a, const Value& b) {
+        if (a.getType() != b.getType()) {
+            return false;
+        }
+        switch (a.getType()) {
+        case Type::INT: return a.as<int>() == b.as<int>();
+        case Type::DOUBLE: return a.as<double>() == b.as<double>();
+        case Type::BOOL: return a.as<bool>() == b.as<bool>();
+        case Type::STRING: return a.as<SharedString>() == b.as<SharedString>();
+        default: return false;
+        }
+    }
+}
+
+HashMap::HashMap(const HashMap& other)
+    : slots(other.slots), count(other.count), tombstones(other.tombstones) {
+    if (other.control) {
+        control = std::make_unique<int8_t[]>(slots.size());
+        std::memcpy(control.get(), other.control.get(), slots.size());
+    }
+}
+
+void HashMap::checkKey(const Value& key) {
+    Type type = key.getType();
+    if (type != Type::INT && type != Type::DOUBLE && type != Type::BOOL && type != Type::STRING) {
+        throw std::runtime_error("invalid map key type: " + typeToString(type));
+    }
+}
+
+size_t HashMap::hashOf(const Value& key) {
+    switch (key.getType()) {
+    case Type::INT: return mix(static_cast<uint64_t>(key.as<int>()));
+    case Type::BOOL: return mix(key.as<bool>() ? 1 : 0) ^ 0x5bd1e995;
+    case Type::DOUBLE: {
+        double d = key.as<double>();
+        if (d == 0.0) d = 0.0; // -0.0 and 0.0 are the same key
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof bits);
+        return mix(bits ^ 0x9e3779b97f4a7c15ULL);
+    }
+    case Type::STRING: return mix(std::hash<std::string_view>()(key.as<SharedString>().view()));
+    default:
+        checkKey(key);
+        return 0;
+    }
+}
+
+// groups are probed in triangular order, which visits every group once
+// when the group count is a power of two
+size_t HashMap::locate(const Value& key, size_t hash) const {
+    if (slots.empty()) {
+        return npos;
+    }
+    size_t groupMask = slots.size() / GROUP_SIZE - 1;
+    size_t group = groupHash(hash) & groupMask;
+    int8_t tag = controlByte(hash);
+    for (size_t step = 1; ; ++step) {
+        const int8_t* bytes = control.get() + group * GROUP_SIZE;
+        for (unsigned mask = matchByte(bytes, tag); mask != 0; mask &= mask - 1) {
+            size_t slot = group * GROUP_SIZE + lowestBit(mask);
+            if (slots[slot].hash == hash && sameKey(slots[slot].key, key)) {
+                return slot;
+            }
+        }
+        if (matchByte(bytes, EMPTY) != 0) {
+            return npos; // key would have been placed here
+        }
+        if (step > groupMask) {
+            return npos;
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+size_t HashMap::freeSlot(size_t hash) const {
+    size_t groupMask = slots.size() / GROUP_SIZE - 1;
+    size_t group = groupHash(hash) & groupMask;
+    for (size_t step = 1; ; ++step) {
+        if (unsigned mask = matchFree(control.get() + group * GROUP_SIZE)) {
+            return group * GROUP_SIZE + lowestBit(mask);
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+const Value* HashMap::find(const Value& key) const {
+    size_t slot = locate(key, hashOf(key));
+    return slot == npos ? nullptr : &slots[slot].value;
+}
+
+Value* HashMap::find(const Value& key) {
+    size_t slot = locate(key, hashOf(key));
+    return slot == npos ? nullptr : &slots[slot].value;
+}
+
+Value& HashMap::operator[](const Value& key) {
+    size_t hash = hashOf(key);
+    size_t slot = locate(key, hash);
+    if (slot != npos) {
+        return slots[slot].value;
+    }
+
+    // keep at most 7/8 of the slots in use, tombstones included
+    if ((count + tombstones + 1) * 8 > slots.size() * 7) {
+        grow();
+    }
+    slot = freeSlot(hash);
+    if (control[slot] == DELETED) {
+        tombstones--;
+    }
+    control[slot] = controlByte(hash);
+    slots[slot] = Slot{ key, Value(), hash };
+    count++;
+    return slots[slot].value;
+}
+
+bool HashMap::erase(const Value& key) {
+    size_t slot = locate(key, hashOf(key));
+    if (slot == npos) {
+        return false;
+    }
+    // a group that still has an empty slot never made a probe move on past
+    // it, so the erased slot can become empty again instead of a tombstone
+    const int8_t* group = control.get() + slot / GROUP_SIZE * GROUP_SIZE;
+    if (matchByte(group, EMPTY) != 0) {
+        control[slot] = EMPTY;
+    }
+    else {
+        control[slot] = DELETED;
+        tombstones++;
+    }
+    slots[slot] = Slot{};
+    count--;
+    return true;
+}
+
+void HashMap::grow() {
+    size_t groups = slots.empty() ? MIN_GROUPS : slots.size() / GROUP_SIZE;
+    // only double when the table is really full, not just full of tombstones
+    if (count * 2 >= slots.size()) {
+        groups *= 2;
+    }
+
+    std::vector<Slot> old = std::move(slots);
+    std::unique_ptr<int8_t[]> oldControl = std::move(control);
+
+    slots = std::vector<Slot>(groups * GROUP_SIZE);
+    control = std::make_unique<int8_t[]>(slots.size());
+    std::memset(control.get(), static_cast<unsigned char>(EMPTY), slots.size());
+    tombstones = 0;
+
+    // stored hashes mean no key is hashed again here
+    for (size_t i = 0; i < old.size(); ++i) {
+        if (oldControl[i] >= 0) {
+            size_t slot = freeSlot(old[i].hash);
+            control[slot] = oldControl[i];
+            slots[slot] = std::move(old[i]);
+        }
+    }
+}
+
+const HashMap& Map::read() const {
+    static const HashMap empty;
+    return table ? *table : empty;
+}
+
+HashMap& Map::write() {
+    if (!table) {
+        table = std::make_shared<HashMap>();
+    }
+    else if (table.use_count() > 1) {
+        table = std::make_shared<HashMap>(*table);
+    }
+    return *table;
+}
+
+size_t Map::size() const {
+    return table ? table->size() : 0;
+}
@@ -0,0 +1,67 @@
+#ifndef SEASHELLS_HASHMAP_H
+#define SEASHELLS_HASHMAP_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Value.h"
+
+// open-addressing table in the style of Swiss tables: one control byte per
+// slot holds 7 bits of the key's hash, so a probe compares a whole group of
+// 16 slots at once and only touches keys whose bits match. Each slot keeps
+// its key's full hash, so growing never rehashes a key
+class HashMap {
+public:
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    HashMap() = default;
+    HashMap(const HashMap& other);
+    HashMap& operator=(const HashMap&) = delete;
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+
+    // null if key is absent
+    const Value* find(const Value& key) const;
+    Value* find(const Value& key);
+
+    // slot for key, default constructed if it was absent
+    Value& operator[](const Value& key);
+
+    // true if key was present
+    bool erase(const Value& key);
+
+    // slot index iteration over occupied slots, in table order
+    bool occupied(size_t slot) const { return control[slot] >= 0; }
+    const Value& keyAt(size_t slot) const { return slots[slot].key; }
+    const Value& valueAt(size_t slot) const { return slots[slot].value; }
+
+    // only int, double, bool and string values can be keys
+    static void checkKey(const Value& key);
+
+private:
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    struct Slot {
+        Value key;
+        Value value;
+        size_t hash = 0;
+    };
+
+    static size_t hashOf(const Value& key);
+
+    // index of key's slot, or npos
+    size_t locate(const Value& key, size_t hash) const;
+    // first empty or deleted slot on hash's probe sequence
+    size_t freeSlot(size_t hash) const;
+    void grow();
+
+    std::unique_ptr<int8_t[]> control;
+    std::vector<Slot> slots;
+    size_t count = 0;
+    size_t tombstones = 0;
+};
+
+#endif //SEASHELLS_HASHMAP_H
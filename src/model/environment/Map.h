@@ -0,0 +1,24 @@
+#ifndef SEASHELLS_MAP_H
+#define SEASHELLS_MAP_H
+
+#include <cstddef>
+#include <memory>
+
+class HashMap;
+
+// copy-on-write handle to a HashMap: copying a map value only bumps a
+// refcount, the table is cloned on the first write through a shared handle
+class Map {
+public:
+    Map() = default;
+
+    const HashMap& read() const;
+    HashMap& write();
+
+    size_t size() const;
+
+private:
+    std::shared_ptr<HashMap> table; // null until the first write
+};
+
+#endif //SEASHELLS_MAP_H
@@ -0,0 +1,41 @@
+#ifndef SEASHELLS_MATRIX_H
+#define SEASHELLS_MATRIX_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// dense row-major matrix of doubles. Copies share the storage until one of
+// them writes, so passing a matrix around never copies its elements
+class Matrix {
+public:
+    Matrix() = default;
+    Matrix(size_t rows, size_t cols)
+        : storage(std::make_shared<Storage>(Storage{ rows, cols, std::vector<double>(rows * cols, 0.0) })) {}
+
+    size_t rows() const { return storage ? storage->rows : 0; }
+    size_t cols() const { return storage ? storage->cols : 0; }
+
+    const double* data() const { return storage ? storage->values.data() : nullptr; }
+
+    // unshares the storage first if another matrix still uses it
+    double* mutableData() {
+        if (storage && storage.use_count() > 1) {
+            storage = std::make_shared<Storage>(*storage);
+        }
+        return storage ? storage->values.data() : nullptr;
+    }
+
+    double at(size_t row, size_t col) const { return storage->values[row * storage->cols + col]; }
+
+private:
+    struct Storage {
+        size_t rows;
+        size_t cols;
+        std::vector<double> values;
+    };
+
+    std::shared_ptr<Storage> storage; // null for the empty 0x0 matrix
+};
+
+#endif //SEASHELLS_MATRIX_H
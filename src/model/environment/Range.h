@@ -0,0 +1,30 @@
+#ifndef SEASHELLS_RANGE_H
+#define SEASHELLS_RANGE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// arithmetic progression start, start + step, ... stopping before end;
+// only the bounds are stored, elements are computed on access
+struct Range {
+    int start = 0;
+    int end = 0;
+    int step = 1;
+
+    size_t size() const {
+        int64_t span = static_cast<int64_t>(end) - start;
+        if (step > 0 && span > 0) {
+            return static_cast<size_t>((span + step - 1) / step);
+        }
+        if (step < 0 && span < 0) {
+            return static_cast<size_t>((-span - step - 1) / -static_cast<int64_t>(step));
+        }
+        return 0;
+    }
+
+    int at(size_t index) const {
+        return static_cast<int>(start + static_cast<int64_t>(index) * step);
+    }
+};
+
+#endif //SEASHELLS_RANGE_H
@@ -1,27 +1,97 @@
 #include "Scope.h"
 
-bool Scope::hasVariable(const std::string& name) const {
-    return variables.find(name) != variables.end();
+namespace {
+    constexpr size_t INITIAL_CAPACITY = 8;
+
+    // fibonacci hashing spreads consecutive ids across the table
+    size_t spread(SymbolId symbol) {
+        return static_cast<size_t>(symbol * 0x9E3779B97F4A7C15ull >> 32);
+    }
+}
+
+size_t Scope::probe(SymbolId symbol) const {
+    size_t mask = slots.size() - 1;
+    size_t i = spread(symbol) & mask;
+    while (slots[i].symbol != NO_SYMBOL && slots[i].symbol != symbol) {
+        i = (i + 1) & mask;
+    }
+    return i;
 }
 
-void Scope::declareVariable(const std::string& name, Type type, const Value& value) {
-    if (hasVariable(name)) {
-        throw std::runtime_error("Variable already declared: " + name);
+void Scope::grow() {
+    std::vector<Slot> old = std::move(slots);
+    slots = std::vector<Slot>(old.empty() ? INITIAL_CAPACITY : old.size() * 2);
+    for (auto& slot : old) {
+        if (slot.symbol != NO_SYMBOL) {
+            slots[probe(slot.symbol)] = std::move(slot);
+        }
     }
+}
+
+bool Scope::hasVariable(SymbolId symbol) const {
+    if (count == 0) {
+        return false;
+    }
+    return slots[probe(symbol)].symbol == symbol;
+}
+
+void Scope::declareVariable(SymbolId symbol, Type type, Value value) {
     try {
-        Variable var{ type, value };
-        variables.emplace(name, std::move(var));
+        // keep the load factor under 3/4 so probe sequences stay short
+        if ((count + 1) * 4 > slots.size() * 3) {
+            grow();
+        }
+        Slot& slot = slots[probe(symbol)];
+        if (slot.symbol == symbol) {
+            throw std::runtime_error("Variable already declared: " + SymbolTable::name(symbol));
+        }
+        slot.variable = Variable{ type, std::move(value) };
+        slot.symbol = symbol;
+        count++;
     }
     catch (const std::bad_alloc& e) {
-        std::cerr << "Memory allocation failed while declaring variable: " << name << std::endl;
+        std::cerr << "Memory allocation failed while declaring variable: " << SymbolTable::name(symbol) << std::endl;
         throw;
     }
 }
 
-Variable& Scope::getVariable(const std::string& name) {
-    auto it = variables.find(name);
-    if (it == variables.end()) {
-        throw std::runtime_error("Variable not found: " + name);
+Variable& Scope::getVariable(SymbolId symbol) {
+    Variable* var = findVariable(symbol);
+    if (!var) {
+        throw std::runtime_error("Variable not found: " + SymbolTable::name(symbol));
+    }
+    return *var;
+}
+
+bool Scope::removeVariable(SymbolId symbol) {
+    if (count == 0) {
+        return false;
+    }
+    size_t mask = slots.size() - 1;
+    size_t hole = probe(symbol);
+    if (slots[hole].symbol != symbol) {
+        return false;
+    }
+
+    // backward shift deletion, pulls later entries of the probe chain into
+    // the hole so lookups never need tombstones
+    for (size_t i = (hole + 1) & mask; slots[i].symbol != NO_SYMBOL; i = (i + 1) & mask) {
+        size_t home = spread(slots[i].symbol) & mask;
+        bool movable = (hole <= i) ? (home <= hole || home > i) : (home <= hole && home > i);
+        if (movable) {
+            slots[hole] = std::move(slots[i]);
+            hole = i;
+        }
+    }
+    slots[hole] = Slot{};
+    count--;
+    return true;
+}
+
+Variable* Scope::findVariable(SymbolId symbol) {
+    if (count == 0) {
+        return nullptr;
     }
-    return it->second;
+    Slot& slot = slots[probe(symbol)];
+    return slot.symbol == symbol ? &slot.variable : nullptr;
 }
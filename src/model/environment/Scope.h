@@ -1,27 +1,51 @@
 #ifndef SEASHELLS_SCOPE_H
 #define SEASHELLS_SCOPE_H
 
-#include <map>
+#include <vector>
+#include "Symbol.h"
 #include "Variable.h"
 #include <iostream>
 #include <cctype>
 #include <stdexcept>
 
+// flat open-addressing symbol table keyed by interned ids, linear probing
+// over a power of two sized slot array
 class Scope {
 private:
-    std::map<std::string, Variable> variables;
+    struct Slot {
+        SymbolId symbol = NO_SYMBOL; // NO_SYMBOL marks an empty slot
+        Variable variable;
+    };
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    // index of the slot holding symbol, or of the empty slot where it would go
+    size_t probe(SymbolId symbol) const;
+    void grow();
+
 public:
-    bool hasVariable(const std::string& name) const;
+    bool hasVariable(SymbolId symbol) const;
+
+    void declareVariable(SymbolId symbol, Type type, Value value);
 
-    void declareVariable(const std::string& name, Type type, const Value& value);
+    Variable& getVariable(SymbolId symbol);
 
-    Variable& getVariable(const std::string& name);
+    // single probe lookup, nullptr if the symbol is not declared here
+    Variable* findVariable(SymbolId symbol);
+
+    bool removeVariable(SymbolId symbol);
+
+    size_t size() const { return count; }
 
     void debugPrint() const {
         std::cerr << "Scope variables:" << std::endl;
-        for (const auto& pair : variables) {
+        for (const auto& slot : slots) {
+            if (slot.symbol == NO_SYMBOL) {
+                continue;
+            }
             std::cerr << "  Variable name: ";
-            for (char c : pair.first) {
+            for (char c : SymbolTable::name(slot.symbol)) {
                 if (isprint(c)) {
                     std::cerr << c;
                 }
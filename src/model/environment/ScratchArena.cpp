@@ -0,0 +1,48 @@
+#include "ScratchArena.h"
+#include <algorithm>
+
+void* ScratchArena::do_allocate(size_t bytes, size_t alignment) {
+    while (true) {
+        if (active == chunks.size()) {
+            size_t size = std::max(chunkSize, bytes + alignment);
+            chunks.push_back({ std::make_unique<std::byte[]>(size), size });
+        }
+
+        Chunk& chunk = chunks[active];
+        size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+        if (aligned + bytes <= chunk.size) {
+            offset = aligned + bytes;
+            return chunk.data.get() + aligned;
+        }
+
+        if (offset == 0) {
+            // a kept chunk too small for this request even when empty
+            chunk.size = std::max(chunkSize, bytes + alignment);
+            chunk.data = std::make_unique<std::byte[]>(chunk.size);
+            continue;
+        }
+        active++;
+        offset = 0;
+    }
+}
+
+void ScratchArena::rewind(Mark mark) {
+    active = mark.chunk;
+    offset = mark.offset;
+}
+
+void ScratchArena::release() {
+    if (chunks.size() > 1) {
+        chunks.resize(1);
+    }
+    active = 0;
+    offset = 0;
+}
+
+size_t ScratchArena::bytesReserved() const {
+    size_t total = 0;
+    for (const auto& chunk : chunks) {
+        total += chunk.size;
+    }
+    return total;
+}
@@ -0,0 +1,63 @@
+#ifndef SEASHELLS_SCRATCHARENA_H
+#define SEASHELLS_SCRATCHARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// bump allocator for temporaries that live no longer than one top-level
+// statement; individual deallocations are free, memory is reclaimed by
+// rewinding to a mark or releasing the whole arena
+class ScratchArena : public std::pmr::memory_resource {
+public:
+    struct Mark {
+        size_t chunk;
+        size_t offset;
+    };
+
+    // rewinds the arena to where it was when the frame was opened, so
+    // nested calls only hold on to what the live frames still use
+    class Frame {
+    public:
+        explicit Frame(ScratchArena& arena) : arena(arena), start(arena.mark()) {}
+        ~Frame() { arena.rewind(start); }
+
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+    private:
+        ScratchArena& arena;
+        Mark start;
+    };
+
+    explicit ScratchArena(size_t chunkSize = 64 * 1024) : chunkSize(chunkSize) {}
+
+    Mark mark() const { return { active, offset }; }
+    void rewind(Mark mark);
+
+    // drops everything, keeps the first chunk around for the next statement
+    void release();
+
+    size_t bytesReserved() const;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    size_t chunkSize;
+    std::vector<Chunk> chunks;
+    size_t active = 0; // chunk currently bumped into
+    size_t offset = 0; // first free byte in the active chunk
+};
+
+#endif //SEASHELLS_SCRATCHARENA_H
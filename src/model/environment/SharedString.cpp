@@ -0,0 +1,138 @@
+#include "SharedString.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEASHELL_HAVE_SSE2 1
+#endif
+
+namespace {
+    constexpr size_t MIN_BUFFER_CAPACITY = 64;
+
+    // below this the plain scalar search wins over setting up vectors
+    constexpr size_t SIMD_SEARCH_THRESHOLD = 64;
+
+    size_t scalarFind(std::string_view haystack, std::string_view needle, size_t from) {
+        size_t pos = haystack.find(needle, from);
+        return pos == std::string_view::npos ? SharedString::npos : pos;
+    }
+
+#ifdef SEASHELL_HAVE_SSE2
+    // compares the needle's first and last byte against 16 candidate
+    // positions at once and only runs memcmp where both match
+    size_t simdFind(std::string_view haystack, std::string_view needle, size_t from) {
+        const size_t n = haystack.size();
+        const size_t m = needle.size();
+        const char* data = haystack.data();
+        const __m128i first = _mm_set1_epi8(needle.front());
+        const __m128i last = _mm_set1_epi8(needle.back());
+
+        size_t i = from;
+        for (; i + m - 1 + 16 <= n; i += 16) {
+            __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + m - 1));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+            while (mask != 0) {
+                unsigned bit = 0;
+                while (!(mask & (1u << bit))) bit++;
+                if (m <= 2 || std::memcmp(data + i + bit + 1, needle.data() + 1, m - 2) == 0) {
+                    return i + bit;
+                }
+                mask &= mask - 1;
+            }
+        }
+        return scalarFind(haystack, needle, i);
+    }
+#endif
+}
+
+SharedString::SharedString(std::string_view text) : length(0) {
+    if (text.size() <= INLINE_CAPACITY) {
+        std::memcpy(inlineData, text.data(), text.size());
+        length = static_cast<uint32_t>(text.size());
+    }
+    else {
+        *this = allocate(text, {});
+    }
+}
+
+SharedString SharedString::allocate(std::string_view head, std::string_view tail) {
+    size_t total = head.size() + tail.size();
+    if (total > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("string too long");
+    }
+
+    // headroom so the next few appends can happen in place
+    auto buffer = std::make_shared<Buffer>();
+    buffer->capacity = std::max(total * 2, MIN_BUFFER_CAPACITY);
+    buffer->data = std::make_unique<char[]>(buffer->capacity);
+    std::memcpy(buffer->data.get(), head.data(), head.size());
+    std::memcpy(buffer->data.get() + head.size(), tail.data(), tail.size());
+    buffer->used.store(total, std::memory_order_relaxed);
+    return SharedString(std::move(buffer), 0, static_cast<uint32_t>(total));
+}
+
+SharedString SharedString::substr(size_t pos, size_t count) const {
+    if (pos > length) {
+        throw std::out_of_range("substring start " + std::to_string(pos) + " past end of string");
+    }
+    size_t n = std::min(count, length - pos);
+    if (!buffer || n <= INLINE_CAPACITY) {
+        return SharedString(view().substr(pos, n));
+    }
+    return SharedString(buffer, offset + static_cast<uint32_t>(pos), static_cast<uint32_t>(n));
+}
+
+size_t SharedString::find(std::string_view needle, size_t from) const {
+    std::string_view haystack = view();
+    if (from > haystack.size() || needle.size() > haystack.size() - from) {
+        return npos;
+    }
+    if (needle.empty()) {
+        return from;
+    }
+    if (needle.size() == 1) {
+        // memchr is already vectorized by the C library
+        const void* hit = std::memchr(haystack.data() + from, needle.front(), haystack.size() - from);
+        return hit ? static_cast<const char*>(hit) - haystack.data() : npos;
+    }
+#ifdef SEASHELL_HAVE_SSE2
+    if (haystack.size() - from >= SIMD_SEARCH_THRESHOLD) {
+        return simdFind(haystack, needle, from);
+    }
+#endif
+    return scalarFind(haystack, needle, from);
+}
+
+SharedString operator+(const SharedString& left, const SharedString& right) {
+    size_t total = left.size() + right.size();
+    if (right.empty()) {
+        return left;
+    }
+    if (total <= SharedString::INLINE_CAPACITY) {
+        SharedString result;
+        std::memcpy(result.inlineData, left.view().data(), left.size());
+        std::memcpy(result.inlineData + left.size(), right.view().data(), right.size());
+        result.length = static_cast<uint32_t>(total);
+        return result;
+    }
+
+    // if left ends exactly where its buffer is filled up to, claim the bytes
+    // behind it; nobody else can see them, and existing strings keep their
+    // own ranges, so the append is invisible to them
+    if (left.buffer && total <= std::numeric_limits<uint32_t>::max()) {
+        SharedString::Buffer& buffer = *left.buffer;
+        size_t end = left.offset + left.size();
+        size_t expected = end;
+        if (end + right.size() <= buffer.capacity &&
+            buffer.used.compare_exchange_strong(expected, end + right.size())) {
+            std::memcpy(buffer.data.get() + end, right.view().data(), right.size());
+            return SharedString(left.buffer, left.offset, static_cast<uint32_t>(total));
+        }
+    }
+    return SharedString::allocate(left.view(), right.view());
+}
@@ -0,0 +1,80 @@
+#ifndef SEASHELLS_SHAREDSTRING_H
+#define SEASHELLS_SHAREDSTRING_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// immutable string value with cheap copies: short strings are stored inline,
+// longer ones share a refcounted buffer. A buffer is append-only and its
+// bytes never move, so concatenating onto the string that ends at the
+// buffer's fill mark extends it in place, which keeps s = s + "x" linear
+class SharedString {
+public:
+    static constexpr size_t INLINE_CAPACITY = 16;
+
+    SharedString() : length(0) {}
+    SharedString(std::string_view text);
+    SharedString(const std::string& text) : SharedString(std::string_view(text)) {}
+    SharedString(const char* text) : SharedString(std::string_view(text)) {}
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    // valid for as long as this string (or a copy of it) is alive
+    std::string_view view() const {
+        return buffer ? std::string_view(buffer->data.get() + offset, length)
+            : std::string_view(inlineData, length);
+    }
+
+    std::string str() const { return std::string(view()); }
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // slice sharing this string's buffer, no bytes are copied unless the
+    // result is short enough to live inline
+    SharedString substr(size_t pos, size_t count = npos) const;
+
+    // index of the first occurrence of needle at or after from, or npos
+    size_t find(std::string_view needle, size_t from = 0) const;
+
+    bool startsWith(std::string_view prefix) const {
+        return view().substr(0, prefix.size()) == prefix;
+    }
+
+    friend SharedString operator+(const SharedString& left, const SharedString& right);
+
+    friend bool operator==(const SharedString& a, const SharedString& b) { return a.view() == b.view(); }
+    friend bool operator!=(const SharedString& a, const SharedString& b) { return a.view() != b.view(); }
+    friend bool operator<(const SharedString& a, const SharedString& b) { return a.view() < b.view(); }
+    friend bool operator<=(const SharedString& a, const SharedString& b) { return a.view() <= b.view(); }
+    friend bool operator>(const SharedString& a, const SharedString& b) { return a.view() > b.view(); }
+    friend bool operator>=(const SharedString& a, const SharedString& b) { return a.view() >= b.view(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const SharedString& s) {
+        return os << s.view();
+    }
+
+private:
+    struct Buffer {
+        std::unique_ptr<char[]> data;
+        size_t capacity;
+        std::atomic<size_t> used; // bytes handed out to strings so far
+    };
+
+    SharedString(std::shared_ptr<Buffer> buffer, uint32_t offset, uint32_t length)
+        : buffer(std::move(buffer)), offset(offset), length(length) {}
+
+    // copies text into a fresh buffer with room to grow
+    static SharedString allocate(std::string_view head, std::string_view tail);
+
+    std::shared_ptr<Buffer> buffer; // null for inline strings
+    uint32_t offset = 0;
+    uint32_t length;
+    char inlineData[INLINE_CAPACITY];
+};
+
+#endif //SEASHELLS_SHAREDSTRING_H
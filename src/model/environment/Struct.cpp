@@ -0,0 +1,183 @@
+#include "Struct.h"
+#include "Value.h"
+#include <atomic>
+
+namespace {
+    std::atomic<uint64_t> nextLayoutId{ 1 };
+
+    bool compatible(Type source, Type target) {
+        return source == target || (target == Type::DOUBLE && source == Type::INT);
+    }
+}
+
+StructLayout::StructLayout(SymbolId name, std::vector<std::pair<SymbolId, Type>> fields)
+    : id(nextLayoutId.fetch_add(1)), name(name), fields(std::move(fields)) {
+    if (this->fields.size() > MAX_FIELDS) {
+        throw std::runtime_error("struct " + SymbolTable::name(name) + " has too many fields");
+    }
+    for (const auto& field : this->fields) {
+        if (offsetOf(field.first) != &field - this->fields.data()) {
+            throw std::runtime_error("duplicate field '" + SymbolTable::name(field.first) + "' in struct " +
+                SymbolTable::name(name));
+        }
+        Type type = field.second;
+        if (type != Type::INT && type != Type::DOUBLE && type != Type::BOOL && type != Type::STRING) {
+            throw std::runtime_error("struct fields must be int, double, bool or string, '" +
+                SymbolTable::name(field.first) + "' is " + typeToString(type));
+        }
+    }
+}
+
+int StructLayout::offsetOf(SymbolId field) const {
+    for (size_t slot = 0; slot < fields.size(); ++slot) {
+        if (fields[slot].first == field) {
+            return static_cast<int>(slot);
+        }
+    }
+    return -1;
+}
+
+Value StructLayout::coerce(size_t slot, const Value& value) const {
+    Type target = fieldType(slot);
+    if (!compatible(value.getType(), target)) {
+        throw std::runtime_error("type mismatch for field '" + SymbolTable::name(fieldName(slot)) + "'. expected " +
+            typeToString(target) + ", got " + typeToString(value.getType()));
+    }
+    if (target == Type::DOUBLE && value.getType() == Type::INT) {
+        return static_cast<double>(value.as<int>());
+    }
+    return value;
+}
+
+Record::Record(std::shared_ptr<const StructLayout> layout)
+    : layout(std::move(layout)), fields(std::make_shared<std::vector<Value>>()) {
+    fields->reserve(this->layout->fieldCount());
+    for (size_t slot = 0; slot < this->layout->fieldCount(); ++slot) {
+        fields->push_back(Value::defaultFor(this->layout->fieldType(slot)));
+    }
+}
+
+const Value& Record::field(size_t slot) const {
+    return (*fields)[slot];
+}
+
+void Record::setField(size_t slot, const Value& value) {
+    Value stored = layout->coerce(slot, value);
+    if (fields.use_count() > 1) {
+        fields = std::make_shared<std::vector<Value>>(*fields);
+    }
+    (*fields)[slot] = std::move(stored);
+}
+
+StructArray::StructArray(std::shared_ptr<const StructLayout> layout, size_t length)
+    : layout(std::move(layout)), columns(std::make_shared<Columns>()) {
+    columns->length = length;
+    for (size_t slot = 0; slot < this->layout->fieldCount(); ++slot) {
+        switch (this->layout->fieldType(slot)) {
+        case Type::INT: columns->data.emplace_back(std::vector<int>(length)); break;
+        case Type::DOUBLE: columns->data.emplace_back(std::vector<double>(length)); break;
+        case Type::BOOL: columns->data.emplace_back(std::vector<uint8_t>(length)); break;
+        default: columns->data.emplace_back(std::vector<SharedString>(length)); break;
+        }
+    }
+}
+
+StructArray::Columns& StructArray::writableColumns() {
+    if (columns.use_count() > 1) {
+        columns = std::make_shared<Columns>(*columns);
+    }
+    return *columns;
+}
+
+Value StructArray::get(size_t row, size_t slot) const {
+    return std::visit([row](const auto& column) -> Value {
+        using T = typename std::decay_t<decltype(column)>::value_type;
+        if constexpr (std::is_same_v<T, uint8_t>) {
+            return column[row] != 0;
+        }
+        else {
+            return column[row];
+        }
+    }, columns->data[slot]);
+}
+
+void StructArray::set(size_t row, size_t slot, const Value& value) {
+    Value stored = layout->coerce(slot, value);
+    std::visit([&](auto& column) {
+        using T = typename std::decay_t<decltype(column)>::value_type;
+        if constexpr (std::is_same_v<T, uint8_t>) {
+            column[row] = stored.as<bool>() ? 1 : 0;
+        }
+        else {
+            column[row] = stored.as<T>();
+        }
+    }, writableColumns().data[slot]);
+}
+
+Record StructArray::row(size_t row) const {
+    Record record(layout);
+    for (size_t slot = 0; slot < layout->fieldCount(); ++slot) {
+        record.setField(slot, get(row, slot));
+    }
+    return record;
+}
+
+void StructArray::setRow(size_t row, const Record& record) {
+    if (record.getLayout().getId() != layout->getId()) {
+        throw std::runtime_error("cannot store a " + SymbolTable::name(record.getLayout().getName()) +
+            " in an array of " + SymbolTable::name(layout->getName()));
+    }
+    for (size_t slot = 0; slot < layout->fieldCount(); ++slot) {
+        set(row, slot, record.field(slot));
+    }
+}
+
+std::vector<Value> StructArray::column(size_t slot) const {
+    std::vector<Value> values;
+    values.reserve(size());
+    std::visit([&](const auto& column) {
+        using T = typename std::decay_t<decltype(column)>::value_type;
+        for (const T& element : column) {
+            if constexpr (std::is_same_v<T, uint8_t>) {
+                values.emplace_back(element != 0);
+            }
+            else {
+                values.emplace_back(element);
+            }
+        }
+    }, columns->data[slot]);
+    return values;
+}
+
+void StructArray::permuteRows(const std::vector<size_t>& order) {
+    gatherRows(order);
+}
+
+void StructArray::eraseRows(const std::vector<bool>& erased) {
+    std::vector<size_t> kept;
+    kept.reserve(size());
+    for (size_t row = 0; row < size(); ++row) {
+        if (!erased[row]) {
+            kept.push_back(row);
+        }
+    }
+    gatherRows(kept);
+}
+
+// always builds fresh columns, so shared ones are never copied first
+void StructArray::gatherRows(const std::vector<size_t>& rows) {
+    auto gathered = std::make_shared<Columns>();
+    gathered->length = rows.size();
+    gathered->data.reserve(columns->data.size());
+    for (const Column& column : columns->data) {
+        std::visit([&](const auto& values) {
+            std::decay_t<decltype(values)> picked;
+            picked.reserve(rows.size());
+            for (size_t row : rows) {
+                picked.push_back(values[row]);
+            }
+            gathered->data.emplace_back(std::move(picked));
+        }, column);
+    }
+    columns = std::move(gathered);
+}
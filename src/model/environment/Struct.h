@@ -0,0 +1,105 @@
+#ifndef SEASHELLS_STRUCT_H
+#define SEASHELLS_STRUCT_H
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "SharedString.h"
+#include "Symbol.h"
+
+class Value;
+enum class Type;
+
+// field layout of a struct type: a field's offset is its position in the
+// declaration. Layouts never change once built, a redeclared struct gets a
+// new layout with a new id, so an id identifies a layout for good
+class StructLayout {
+public:
+    // slots have to fit the 16 bits field accesses cache them in
+    static constexpr size_t MAX_FIELDS = 0xFFFF;
+
+    StructLayout(SymbolId name, std::vector<std::pair<SymbolId, Type>> fields);
+
+    uint64_t getId() const { return id; }
+    SymbolId getName() const { return name; }
+    size_t fieldCount() const { return fields.size(); }
+    SymbolId fieldName(size_t slot) const { return fields[slot].first; }
+    Type fieldType(size_t slot) const { return fields[slot].second; }
+
+    // slot of field, or -1
+    int offsetOf(SymbolId field) const;
+
+    // value converted for storing in slot, throws on a type mismatch
+    Value coerce(size_t slot, const Value& value) const;
+
+private:
+    uint64_t id;
+    SymbolId name;
+    std::vector<std::pair<SymbolId, Type>> fields;
+};
+
+// one struct value, its fields stored at their layout offsets; copies share
+// the fields until one of them writes
+class Record {
+public:
+    explicit Record(std::shared_ptr<const StructLayout> layout);
+
+    const StructLayout& getLayout() const { return *layout; }
+    const std::shared_ptr<const StructLayout>& layoutHandle() const { return layout; }
+
+    const Value& field(size_t slot) const;
+    void setField(size_t slot, const Value& value);
+
+private:
+    std::shared_ptr<const StructLayout> layout;
+    std::shared_ptr<std::vector<Value>> fields;
+};
+
+// array of structs kept as one typed column per field, so sweeping a field
+// over every element reads contiguous ints or doubles
+class StructArray {
+public:
+    StructArray(std::shared_ptr<const StructLayout> layout, size_t length);
+
+    const StructLayout& getLayout() const { return *layout; }
+    size_t size() const { return columns->length; }
+
+    Value get(size_t row, size_t slot) const;
+    void set(size_t row, size_t slot, const Value& value);
+
+    // element row gathered into a record, and scattered back
+    Record row(size_t row) const;
+    void setRow(size_t row, const Record& record);
+
+    // every value of one field, in element order
+    std::vector<Value> column(size_t slot) const;
+
+    // reorders the elements column by column, element i becomes the one
+    // that was at order[i]
+    void permuteRows(const std::vector<size_t>& order);
+    // drops every element i with erased[i] set, the rest keep their order
+    void eraseRows(const std::vector<bool>& erased);
+
+    // takes sole ownership of the columns, after which writes to different
+    // elements can't touch shared state
+    void unshare() { writableColumns(); }
+
+private:
+    using Column = std::variant<std::vector<int>, std::vector<double>, std::vector<uint8_t>, std::vector<SharedString>>;
+
+    struct Columns {
+        size_t length;
+        std::vector<Column> data;
+    };
+
+    Columns& writableColumns();
+    // new columns holding the listed rows in that order
+    void gatherRows(const std::vector<size_t>& rows);
+
+    std::shared_ptr<const StructLayout> layout;
+    std::shared_ptr<Columns> columns;
+};
+
+#endif //SEASHELLS_STRUCT_H
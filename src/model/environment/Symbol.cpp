@@ -0,0 +1,34 @@
+#include "Symbol.h"
+#include <stdexcept>
+
+SymbolTable& SymbolTable::instance() {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolId SymbolTable::intern(const std::string& name) {
+    SymbolTable& table = instance();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    if (table.names.empty()) {
+        table.names.emplace_back(); // reserve NO_SYMBOL
+    }
+    auto it = table.ids.find(name);
+    if (it != table.ids.end()) {
+        return it->second;
+    }
+    SymbolId id = static_cast<SymbolId>(table.names.size());
+    table.names.push_back(name);
+    table.ids.emplace(name, id);
+    return id;
+}
+
+const std::string& SymbolTable::name(SymbolId id) {
+    SymbolTable& table = instance();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    if (id == NO_SYMBOL || id >= table.names.size()) {
+        throw std::runtime_error("unknown symbol id " + std::to_string(id));
+    }
+    return table.names[id];
+}
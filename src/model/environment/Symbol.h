@@ -0,0 +1,31 @@
+#ifndef SEASHELLS_SYMBOL_H
+#define SEASHELLS_SYMBOL_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// small integer standing in for an interned identifier
+using SymbolId = uint32_t;
+
+// id 0 is never handed out for a real name
+constexpr SymbolId NO_SYMBOL = 0;
+
+// process wide identifier interner, the lexer interns every identifier once
+// and everything downstream compares and hashes the ids instead of strings
+class SymbolTable {
+public:
+    static SymbolId intern(const std::string& name);
+    static const std::string& name(SymbolId id);
+
+private:
+    static SymbolTable& instance();
+
+    std::mutex mutex;
+    std::unordered_map<std::string, SymbolId> ids;
+    std::deque<std::string> names; // index is the id, deque keeps references stable
+};
+
+#endif //SEASHELLS_SYMBOL_H
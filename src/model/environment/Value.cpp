@@ -1,15 +1,35 @@
 #include "Value.h"
+#include "HashMap.h"
 
 Type Value::getType() const {
     if (std::holds_alternative<std::monostate>(data)) return Type::VOID;
     if (std::holds_alternative<int>(data)) return Type::INT;
     if (std::holds_alternative<double>(data)) return Type::DOUBLE;
     if (std::holds_alternative<bool>(data)) return Type::BOOL;
-    if (std::holds_alternative<std::string>(data)) return Type::STRING;
-    if (std::holds_alternative<std::vector<Value>>(data)) return Type::ARRAY;
+    if (std::holds_alternative<SharedString>(data)) return Type::STRING;
+    if (std::holds_alternative<Array>(data)) return Type::ARRAY;
+    if (std::holds_alternative<Range>(data)) return Type::RANGE;
+    if (std::holds_alternative<Map>(data)) return Type::MAP;
+    if (std::holds_alternative<Matrix>(data)) return Type::MATRIX;
+    if (std::holds_alternative<Record>(data)) return Type::STRUCT;
+    if (std::holds_alternative<StructArray>(data)) return Type::STRUCT_ARRAY;
     throw std::runtime_error("Unknown type");
 }
 
+Value Value::defaultFor(Type type) {
+    switch (type) {
+    case Type::INT: return Value(0);
+    case Type::DOUBLE: return Value(0.0);
+    case Type::BOOL: return Value(false);
+    case Type::STRING: return Value(std::string(""));
+    case Type::ARRAY: return Value(std::vector<Value>());
+    case Type::RANGE: return Value(Range{});
+    case Type::MAP: return Value(Map{});
+    case Type::MATRIX: return Value(Matrix{});
+    default: throw std::runtime_error("no default value for type " + typeToString(type));
+    }
+}
+
 std::string typeToString(Type type) {
     switch (type) {
     case Type::VOID: return "void";
@@ -18,6 +38,11 @@ std::string typeToString(Type type) {
     case Type::BOOL: return "bool";
     case Type::STRING: return "string";
     case Type::ARRAY: return "array";
+    case Type::RANGE: return "range";
+    case Type::MAP: return "map";
+    case Type::MATRIX: return "matrix";
+    case Type::STRUCT: return "struct";
+    case Type::STRUCT_ARRAY: return "struct array";
     default: throw std::runtime_error("Unknown type");
     }
 }
@@ -44,11 +69,53 @@ std::string Value::toString() const {
         if constexpr (std::is_same_v<T, std::monostate>) {
             oss << "void";
         }
-        else if constexpr (std::is_same_v<T, std::vector<Value>>) {
+        else if constexpr (std::is_same_v<T, Array>) {
+            const std::vector<Value>& elements = v.read();
+            oss << "[";
+            for (size_t i = 0; i < elements.size(); ++i) {
+                oss << elements[i].toString();
+                if (i < elements.size() - 1) oss << ", ";
+            }
+            oss << "]";
+        }
+        else if constexpr (std::is_same_v<T, Range>) {
+            oss << "range(" << v.start << ", " << v.end << ", " << v.step << ")";
+        }
+        else if constexpr (std::is_same_v<T, Map>) {
+            const HashMap& table = v.read();
+            oss << "{";
+            bool first = true;
+            for (size_t slot = 0; slot < table.capacity(); ++slot) {
+                if (table.occupied(slot)) {
+                    oss << (first ? "" : ", ") << table.keyAt(slot).toString() << ": " << table.valueAt(slot).toString();
+                    first = false;
+                }
+            }
+            oss << "}";
+        }
+        else if constexpr (std::is_same_v<T, Matrix>) {
+            oss << "[";
+            for (size_t row = 0; row < v.rows(); ++row) {
+                oss << (row ? ", [" : "[");
+                for (size_t col = 0; col < v.cols(); ++col) {
+                    oss << (col ? ", " : "") << v.at(row, col);
+                }
+                oss << "]";
+            }
+            oss << "]";
+        }
+        else if constexpr (std::is_same_v<T, Record>) {
+            const StructLayout& layout = v.getLayout();
+            oss << SymbolTable::name(layout.getName()) << "{";
+            for (size_t slot = 0; slot < layout.fieldCount(); ++slot) {
+                oss << (slot ? ", " : "") << SymbolTable::name(layout.fieldName(slot)) << ": " << v.field(slot).toString();
+            }
+            oss << "}";
+        }
+        else if constexpr (std::is_same_v<T, StructArray>) {
             oss << "[";
             for (size_t i = 0; i < v.size(); ++i) {
-                oss << v[i].toString();
-                if (i < v.size() - 1) oss << ", ";
+                oss << (i ? ", " : "") << Value(v.row(i)).toString();
             }
             oss << "]";
         }
@@ -61,6 +128,56 @@ std::string Value::toString() const {
     return oss.str();
 }
 
+size_t Value::length() const {
+    if (const Range* range = std::get_if<Range>(&data)) {
+        return range->size();
+    }
+    if (const Array* elements = std::get_if<Array>(&data)) {
+        return elements->size();
+    }
+    if (const StructArray* structs = std::get_if<StructArray>(&data)) {
+        return structs->size();
+    }
+    throw std::runtime_error("Value is not an array");
+}
+
+std::vector<Value>& Value::elementsForWrite() {
+    if (const Range* range = std::get_if<Range>(&data)) {
+        std::vector<Value> elements;
+        elements.reserve(range->size());
+        for (size_t i = 0; i < range->size(); ++i) {
+            elements.emplace_back(range->at(i));
+        }
+        data = Array(std::move(elements));
+    }
+    else if (std::holds_alternative<StructArray>(data)) {
+        // kept by field; rows are written through structArrayForWrite()
+        throw std::runtime_error("struct array elements can't be written as an array");
+    }
+    return std::get<Array>(data).write();
+}
+
+Array::Array(std::vector<Value> elements) : elements(std::make_shared<std::vector<Value>>(std::move(elements))) {}
+
+const std::vector<Value>& Array::read() const {
+    static const std::vector<Value> empty;
+    return elements ? *elements : empty;
+}
+
+std::vector<Value>& Array::write() {
+    if (!elements) {
+        elements = std::make_shared<std::vector<Value>>();
+    }
+    else if (elements.use_count() > 1) {
+        elements = std::make_shared<std::vector<Value>>(*elements);
+    }
+    return *elements;
+}
+
+size_t Array::size() const {
+    return elements ? elements->size() : 0;
+}
+
 bool Value::toBool() const {
     if (std::holds_alternative<bool>(data)) {
         return std::get<bool>(data);
@@ -71,8 +188,8 @@ bool Value::toBool() const {
     else if (std::holds_alternative<double>(data)) {
         return std::get<double>(data) != 0.0;
     }
-    else if (std::holds_alternative<std::string>(data)) {
-        const std::string& str = std::get<std::string>(data);
+    else if (std::holds_alternative<SharedString>(data)) {
+        std::string_view str = std::get<SharedString>(data).view();
         return !str.empty() && str != "false";
     }
 
@@ -7,6 +7,12 @@
 #include <sstream>
 #include <map>
 #include <vector>
+#include "Array.h"
+#include "Map.h"
+#include "Matrix.h"
+#include "Range.h"
+#include "SharedString.h"
+#include "Struct.h"
 
 enum class Type {
     VOID,
@@ -14,21 +20,36 @@ enum class Type {
     DOUBLE,
     BOOL,
     STRING,
-    ARRAY
+    ARRAY,
+    RANGE,
+    MAP,
+    MATRIX,
+    STRUCT,
+    STRUCT_ARRAY
 };
 
 // represents a value in the shell
 class Value {
 private:
-    std::variant<std::monostate, int, double, bool, std::string, std::vector<Value>> data;
+    std::variant<std::monostate, int, double, bool, SharedString, Array, Range, Map, Matrix, Record, StructArray> data;
 
 public:
     Value() : data() {}
     Value(int v) : data(v) {}
     Value(double v) : data(v) {}
     Value(bool v) : data(v) {}
-    Value(const std::string& v) : data(v) {}
-    Value(const std::vector<Value>& v) : data(v) {}
+    Value(const std::string& v) : data(SharedString(v)) {}
+    Value(const SharedString& v) : data(v) {}
+    Value(const std::vector<Value>& v) : data(Array(v)) {}
+    Value(std::vector<Value>&& v) : data(Array(std::move(v))) {}
+    Value(Range v) : data(v) {}
+    Value(Map v) : data(std::move(v)) {}
+    Value(Matrix v) : data(std::move(v)) {}
+    Value(Record v) : data(std::move(v)) {}
+    Value(StructArray v) : data(std::move(v)) {}
+
+    // zero value used for default initialized variables and array slots
+    static Value defaultFor(Type type);
 
     Type getType() const;
     std::string toString() const;
@@ -36,14 +57,67 @@ public:
 
     template<typename T>
     T get() const {
-        return std::get<T>(data);
+        return as<T>();
+    }
+
+    // borrows the payload instead of copying it, an array's elements are
+    // read as std::vector<Value>
+    template<typename T>
+    const T& as() const {
+        if constexpr (std::is_same_v<T, std::vector<Value>>) {
+            return std::get<Array>(data).read();
+        }
+        else {
+            return std::get<T>(data);
+        }
+    }
+
+    // arrays, ranges and struct arrays can all be indexed and iterated
+    bool isSequence() const {
+        return std::holds_alternative<Array>(data) || std::holds_alternative<Range>(data) ||
+            std::holds_alternative<StructArray>(data);
+    }
+
+    // element count of an array, range or struct array
+    size_t length() const;
+
+    // copy of element index of a sequence, unchecked
+    Value element(size_t index) const {
+        if (const Range* range = std::get_if<Range>(&data)) {
+            return range->at(index);
+        }
+        if (const StructArray* structs = std::get_if<StructArray>(&data)) {
+            return structs->row(index);
+        }
+        return std::get<Array>(data).read()[index];
+    }
+
+    // writable elements, unshared first if needed; a range is materialized
+    // into an array first, a struct array throws
+    std::vector<Value>& elementsForWrite();
+
+    // map payload for in-place updates, unshared first if needed
+    HashMap& mapForWrite() {
+        return std::get<Map>(data).write();
+    }
+
+    Matrix& matrixForWrite() {
+        return std::get<Matrix>(data);
+    }
+
+    Record& recordForWrite() {
+        return std::get<Record>(data);
+    }
+
+    StructArray& structArrayForWrite() {
+        return std::get<StructArray>(data);
     }
 
     Value& atIndex(int index) {
-        if (this->getType() != Type::ARRAY) {
+        if (!isSequence()) {
 			throw std::runtime_error("Value is not an array");
         }
-        return std::get<std::vector<Value>>(data).at(index);
+        return elementsForWrite().at(index);
     }
 
     friend std::ostream& operator<<(std::ostream& os, const Value& v) {
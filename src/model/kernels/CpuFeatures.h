@@ -0,0 +1,12 @@
+#ifndef SEASHELLS_CPUFEATURES_H
+#define SEASHELLS_CPUFEATURES_H
+
+// instruction set extensions the running machine and OS support, probed
+// once so kernels can pick their widest implementation at run time
+struct CpuFeatures {
+    bool avx2 = false;
+
+    static const CpuFeatures& get();
+};
+
+#endif //SEASHELLS_CPUFEATURES_H
@@ -0,0 +1,213 @@
+#include "ElementWise.h"
+#include "CpuFeatures.h"
+#include "Simd.h"
+#include <functional>
+
+namespace {
+    template<typename T>
+    T at(Operand<T> operand, size_t i) {
+        return operand.broadcast ? operand.data[0] : operand.data[i];
+    }
+
+    template<typename T, typename R, typename F>
+    void scalarLoop(F f, Operand<T> a, Operand<T> b, R* out, size_t from, size_t n) {
+        for (size_t i = from; i < n; ++i) {
+            out[i] = static_cast<R>(f(at(a, i), at(b, i)));
+        }
+    }
+
+    template<typename T>
+    void scalarArithmetic(ElementOp op, Operand<T> a, Operand<T> b, T* out, size_t from, size_t n) {
+        switch (op) {
+        case ElementOp::Add: scalarLoop(std::plus<T>(), a, b, out, from, n); break;
+        case ElementOp::Subtract: scalarLoop(std::minus<T>(), a, b, out, from, n); break;
+        case ElementOp::Multiply: scalarLoop(std::multiplies<T>(), a, b, out, from, n); break;
+        case ElementOp::Divide: scalarLoop(std::divides<T>(), a, b, out, from, n); break;
+        default: break;
+        }
+    }
+
+    template<typename T>
+    void scalarCompare(ElementOp op, Operand<T> a, Operand<T> b, uint8_t* out, size_t from, size_t n) {
+        switch (op) {
+        case ElementOp::Equal: scalarLoop(std::equal_to<T>(), a, b, out, from, n); break;
+        case ElementOp::NotEqual: scalarLoop(std::not_equal_to<T>(), a, b, out, from, n); break;
+        case ElementOp::Less: scalarLoop(std::less<T>(), a, b, out, from, n); break;
+        case ElementOp::LessEqual: scalarLoop(std::less_equal<T>(), a, b, out, from, n); break;
+        case ElementOp::Greater: scalarLoop(std::greater<T>(), a, b, out, from, n); break;
+        case ElementOp::GreaterEqual: scalarLoop(std::greater_equal<T>(), a, b, out, from, n); break;
+        default: break;
+        }
+    }
+
+#ifdef SEASHELL_AVX2_KERNELS
+    SEASHELL_TARGET_AVX2 inline __m256d load(Operand<double> operand, size_t i) {
+        return operand.broadcast ? _mm256_set1_pd(operand.data[0]) : _mm256_loadu_pd(operand.data + i);
+    }
+
+    SEASHELL_TARGET_AVX2 inline __m256i load(Operand<int> operand, size_t i) {
+        return operand.broadcast ? _mm256_set1_epi32(operand.data[0])
+            : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(operand.data + i));
+    }
+
+    struct AddLanes {
+        SEASHELL_TARGET_AVX2 static __m256d run(__m256d x, __m256d y) { return _mm256_add_pd(x, y); }
+        SEASHELL_TARGET_AVX2 static __m256i run(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+    };
+
+    struct SubtractLanes {
+        SEASHELL_TARGET_AVX2 static __m256d run(__m256d x, __m256d y) { return _mm256_sub_pd(x, y); }
+        SEASHELL_TARGET_AVX2 static __m256i run(__m256i x, __m256i y) { return _mm256_sub_epi32(x, y); }
+    };
+
+    struct MultiplyLanes {
+        SEASHELL_TARGET_AVX2 static __m256d run(__m256d x, __m256d y) { return _mm256_mul_pd(x, y); }
+        SEASHELL_TARGET_AVX2 static __m256i run(__m256i x, __m256i y) { return _mm256_mullo_epi32(x, y); }
+    };
+
+    // there is no integer division instruction, ints divide in the scalar loop
+    struct DivideLanes {
+        SEASHELL_TARGET_AVX2 static __m256d run(__m256d x, __m256d y) { return _mm256_div_pd(x, y); }
+    };
+
+    // integer comparisons only come as == and >, the rest are built from them;
+    // each returns one bit per lane
+    struct EqualLanes {
+        SEASHELL_TARGET_AVX2 static unsigned run(__m256i x, __m256i y) { return mask(_mm256_cmpeq_epi32(x, y)); }
+        SEASHELL_TARGET_AVX2 static unsigned mask(__m256i m) {
+            return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+        }
+    };
+
+    struct NotEqualLanes {
+        SEASHELL_TARGET_AVX2 static unsigned run(__m256i x, __m256i y) { return EqualLanes::run(x, y) ^ 0xFFu; }
+    };
+
+    struct LessLanes {
+        SEASHELL_TARGET_AVX2 static unsigned run(__m256i x, __m256i y) { return EqualLanes::mask(_mm256_cmpgt_epi32(y, x)); }
+    };
+
+    struct LessEqualLanes {
+        SEASHELL_TARGET_AVX2 static unsigned run(__m256i x, __m256i y) { return EqualLanes::mask(_mm256_cmpgt_epi32(x, y)) ^ 0xFFu; }
+    };
+
+    struct GreaterLanes {
+        SEASHELL_TARGET_AVX2 static unsigned run(__m256i x, __m256i y) { return EqualLanes::mask(_mm256_cmpgt_epi32(x, y)); }
+    };
+
+    struct GreaterEqualLanes {
+        SEASHELL_TARGET_AVX2 static unsigned run(__m256i x, __m256i y) { return EqualLanes::mask(_mm256_cmpgt_epi32(y, x)) ^ 0xFFu; }
+    };
+
+    // each returns how many leading elements it handled, the scalar loop
+    // finishes the tail
+    template<typename Lanes>
+    SEASHELL_TARGET_AVX2 size_t avx2Arithmetic(Operand<double> a, Operand<double> b, double* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, Lanes::run(load(a, i), load(b, i)));
+        }
+        return i;
+    }
+
+    template<typename Lanes>
+    SEASHELL_TARGET_AVX2 size_t avx2Arithmetic(Operand<int> a, Operand<int> b, int* out, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), Lanes::run(load(a, i), load(b, i)));
+        }
+        return i;
+    }
+
+    template<int Predicate>
+    SEASHELL_TARGET_AVX2 size_t avx2Compare(Operand<double> a, Operand<double> b, uint8_t* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(load(a, i), load(b, i), Predicate)));
+            for (size_t k = 0; k < 4; ++k) {
+                out[i + k] = (mask >> k) & 1;
+            }
+        }
+        return i;
+    }
+
+    template<typename Lanes>
+    SEASHELL_TARGET_AVX2 size_t avx2Compare(Operand<int> a, Operand<int> b, uint8_t* out, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            unsigned mask = Lanes::run(load(a, i), load(b, i));
+            for (size_t k = 0; k < 8; ++k) {
+                out[i + k] = (mask >> k) & 1;
+            }
+        }
+        return i;
+    }
+#endif
+}
+
+void applyElementWise(ElementOp op, Operand<double> a, Operand<double> b, double* out, size_t n) {
+    size_t done = 0;
+#ifdef SEASHELL_AVX2_KERNELS
+    if (CpuFeatures::get().avx2) {
+        switch (op) {
+        case ElementOp::Add: done = avx2Arithmetic<AddLanes>(a, b, out, n); break;
+        case ElementOp::Subtract: done = avx2Arithmetic<SubtractLanes>(a, b, out, n); break;
+        case ElementOp::Multiply: done = avx2Arithmetic<MultiplyLanes>(a, b, out, n); break;
+        case ElementOp::Divide: done = avx2Arithmetic<DivideLanes>(a, b, out, n); break;
+        default: break;
+        }
+    }
+#endif
+    scalarArithmetic(op, a, b, out, done, n);
+}
+
+void applyElementWise(ElementOp op, Operand<int> a, Operand<int> b, int* out, size_t n) {
+    size_t done = 0;
+#ifdef SEASHELL_AVX2_KERNELS
+    if (CpuFeatures::get().avx2) {
+        switch (op) {
+        case ElementOp::Add: done = avx2Arithmetic<AddLanes>(a, b, out, n); break;
+        case ElementOp::Subtract: done = avx2Arithmetic<SubtractLanes>(a, b, out, n); break;
+        case ElementOp::Multiply: done = avx2Arithmetic<MultiplyLanes>(a, b, out, n); break;
+        default: break;
+        }
+    }
+#endif
+    scalarArithmetic(op, a, b, out, done, n);
+}
+
+void compareElementWise(ElementOp op, Operand<double> a, Operand<double> b, uint8_t* out, size_t n) {
+    size_t done = 0;
+#ifdef SEASHELL_AVX2_KERNELS
+    if (CpuFeatures::get().avx2) {
+        switch (op) {
+        case ElementOp::Equal: done = avx2Compare<_CMP_EQ_OQ>(a, b, out, n); break;
+        case ElementOp::NotEqual: done = avx2Compare<_CMP_NEQ_UQ>(a, b, out, n); break;
+        case ElementOp::Less: done = avx2Compare<_CMP_LT_OQ>(a, b, out, n); break;
+        case ElementOp::LessEqual: done = avx2Compare<_CMP_LE_OQ>(a, b, out, n); break;
+        case ElementOp::Greater: done = avx2Compare<_CMP_GT_OQ>(a, b, out, n); break;
+        case ElementOp::GreaterEqual: done = avx2Compare<_CMP_GE_OQ>(a, b, out, n); break;
+        default: break;
+        }
+    }
+#endif
+    scalarCompare(op, a, b, out, done, n);
+}
+
+void compareElementWise(ElementOp op, Operand<int> a, Operand<int> b, uint8_t* out, size_t n) {
+    size_t done = 0;
+#ifdef SEASHELL_AVX2_KERNELS
+    if (CpuFeatures::get().avx2) {
+        switch (op) {
+        case ElementOp::Equal: done = avx2Compare<EqualLanes>(a, b, out, n); break;
+        case ElementOp::NotEqual: done = avx2Compare<NotEqualLanes>(a, b, out, n); break;
+        case ElementOp::Less: done = avx2Compare<LessLanes>(a, b, out, n); break;
+        case ElementOp::LessEqual: done = avx2Compare<LessEqualLanes>(a, b, out, n); break;
+        case ElementOp::Greater: done = avx2Compare<GreaterLanes>(a, b, out, n); break;
+        case ElementOp::GreaterEqual: done = avx2Compare<GreaterEqualLanes>(a, b, out, n); break;
+        default: break;
+        }
+    }
+#endif
+    scalarCompare(op, a, b, out, done, n);
+}
@@ -0,0 +1,40 @@
+#ifndef SEASHELLS_ELEMENTWISE_H
+#define SEASHELLS_ELEMENTWISE_H
+
+#include <cstddef>
+#include <cstdint>
+
+enum class ElementOp {
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+};
+
+inline bool isComparison(ElementOp op) {
+    return op >= ElementOp::Equal;
+}
+
+// one side of an element-wise operation, a scalar is broadcast to every element
+template<typename T>
+struct Operand {
+    const T* data;
+    bool broadcast;
+};
+
+// out[i] = a[i] op b[i] for the arithmetic ops; integer division truncates
+// and zero divisors must have been rejected by the caller
+void applyElementWise(ElementOp op, Operand<double> a, Operand<double> b, double* out, size_t n);
+void applyElementWise(ElementOp op, Operand<int> a, Operand<int> b, int* out, size_t n);
+
+// out[i] = a[i] op b[i] ? 1 : 0 for the comparison ops
+void compareElementWise(ElementOp op, Operand<double> a, Operand<double> b, uint8_t* out, size_t n);
+void compareElementWise(ElementOp op, Operand<int> a, Operand<int> b, uint8_t* out, size_t n);
+
+#endif //SEASHELLS_ELEMENTWISE_H
@@ -0,0 +1,103 @@
+#include "MatrixKernels.h"
+#include "CpuFeatures.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+    constexpr size_t TRANSPOSE_TILE = 32;
+
+    // a ROW_BLOCK x DEPTH_BLOCK panel of a and a DEPTH_BLOCK x COL_BLOCK
+    // panel of b fit in L2 together with the c block they update
+    constexpr size_t ROW_BLOCK = 64;
+    constexpr size_t DEPTH_BLOCK = 128;
+    constexpr size_t COL_BLOCK = 256;
+
+    // multiply-adds below which threads are not worth starting
+    constexpr size_t PARALLEL_WORK = 1 << 21;
+
+    // c[i][j0..j1) += a[i][p] * b[p][j0..j1) for one row and one depth index
+    void axpyRow(double scale, const double* b, double* c, size_t count) {
+        for (size_t j = 0; j < count; ++j) {
+            double product = scale * b[j];
+            c[j] += product;
+        }
+    }
+
+#ifdef SEASHELL_AVX2_KERNELS
+    // separate multiply and add, matching the scalar rounding exactly
+    SEASHELL_TARGET_AVX2 void axpyRowAvx2(double scale, const double* b, double* c, size_t count) {
+        __m256d factor = _mm256_set1_pd(scale);
+        size_t j = 0;
+        for (; j + 4 <= count; j += 4) {
+            __m256d product = _mm256_mul_pd(factor, _mm256_loadu_pd(b + j));
+            _mm256_storeu_pd(c + j, _mm256_add_pd(_mm256_loadu_pd(c + j), product));
+        }
+        for (; j < count; ++j) {
+            double product = scale * b[j];
+            c[j] += product;
+        }
+    }
+#endif
+
+    using AxpyFn = void (*)(double, const double*, double*, size_t);
+
+    // rows [rowBegin, rowEnd) of c, walked block by block; depth blocks go
+    // in increasing order so each c[i][j] sees its products in k order
+    void multiplyRows(AxpyFn axpy, const double* a, const double* b, double* c,
+        size_t rowBegin, size_t rowEnd, size_t k, size_t m) {
+        for (size_t j0 = 0; j0 < m; j0 += COL_BLOCK) {
+            size_t width = std::min(COL_BLOCK, m - j0);
+            for (size_t p0 = 0; p0 < k; p0 += DEPTH_BLOCK) {
+                size_t p1 = std::min(k, p0 + DEPTH_BLOCK);
+                for (size_t i = rowBegin; i < rowEnd; ++i) {
+                    const double* aRow = a + i * k;
+                    double* cRow = c + i * m + j0;
+                    for (size_t p = p0; p < p1; ++p) {
+                        axpy(aRow[p], b + p * m + j0, cRow, width);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void transposeMatrix(const double* in, size_t rows, size_t cols, double* out) {
+    for (size_t i0 = 0; i0 < rows; i0 += TRANSPOSE_TILE) {
+        size_t i1 = std::min(rows, i0 + TRANSPOSE_TILE);
+        for (size_t j0 = 0; j0 < cols; j0 += TRANSPOSE_TILE) {
+            size_t j1 = std::min(cols, j0 + TRANSPOSE_TILE);
+            for (size_t i = i0; i < i1; ++i) {
+                for (size_t j = j0; j < j1; ++j) {
+                    out[j * rows + i] = in[i * cols + j];
+                }
+            }
+        }
+    }
+}
+
+void multiplyMatrices(const double* a, const double* b, double* c, size_t n, size_t k, size_t m) {
+    if (n == 0 || k == 0 || m == 0) {
+        return;
+    }
+    AxpyFn axpy = axpyRow;
+#ifdef SEASHELL_AVX2_KERNELS
+    if (CpuFeatures::get().avx2) {
+        axpy = axpyRowAvx2;
+    }
+#endif
+
+    size_t rowBlocks = (n + ROW_BLOCK - 1) / ROW_BLOCK;
+    auto run = [&](size_t block) {
+        multiplyRows(axpy, a, b, c, block * ROW_BLOCK, std::min(n, (block + 1) * ROW_BLOCK), k, m);
+    };
+    // row blocks write disjoint parts of c, so they need no locking
+    if (n * k * m >= PARALLEL_WORK && rowBlocks > 1) {
+        ThreadPool::shared().parallelFor(rowBlocks, run);
+    }
+    else {
+        for (size_t block = 0; block < rowBlocks; ++block) {
+            run(block);
+        }
+    }
+}
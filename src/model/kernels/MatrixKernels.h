@@ -0,0 +1,17 @@
+#ifndef SEASHELLS_MATRIXKERNELS_H
+#define SEASHELLS_MATRIXKERNELS_H
+
+#include <cstddef>
+
+// all matrices are dense and row-major
+
+// out (cols x rows) = in (rows x cols) transposed, copied tile by tile so
+// both sides stay in cache
+void transposeMatrix(const double* in, size_t rows, size_t cols, double* out);
+
+// c (n x m) = a (n x k) * b (k x m); c must be zeroed. Every c[i][j] sums
+// its products in increasing k order whatever the blocking, thread count
+// or instruction set, so results are reproducible
+void multiplyMatrices(const double* a, const double* b, double* c, size_t n, size_t k, size_t m);
+
+#endif //SEASHELLS_MATRIXKERNELS_H
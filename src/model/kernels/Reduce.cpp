@@ -0,0 +1,218 @@
+#include "Reduce.h"
+#include "CpuFeatures.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 16 * 1024;
+    // below this, waking other threads costs more than it saves
+    constexpr size_t PARALLEL_THRESHOLD = 4 * BLOCK_SIZE;
+
+    // reduces every block with reduceBlock(begin, end) and folds the block
+    // results in block order
+    template<typename R, typename BlockFn, typename CombineFn>
+    R reduceBlocks(size_t n, BlockFn reduceBlock, CombineFn combine) {
+        size_t blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        std::vector<R> partial(blocks);
+        auto run = [&](size_t block) {
+            partial[block] = reduceBlock(block * BLOCK_SIZE, std::min(n, (block + 1) * BLOCK_SIZE));
+        };
+        if (n >= PARALLEL_THRESHOLD) {
+            ThreadPool::shared().parallelFor(blocks, run);
+        }
+        else {
+            for (size_t block = 0; block < blocks; ++block) {
+                run(block);
+            }
+        }
+        R result = partial[0];
+        for (size_t block = 1; block < blocks; ++block) {
+            result = combine(result, partial[block]);
+        }
+        return result;
+    }
+
+    // four interleaved accumulators folded as (0 + 1) + (2 + 3), then the
+    // tail; the AVX2 versions keep exactly this order
+    double sumBlock(const double* data, size_t begin, size_t end) {
+        double lanes[4] = { 0, 0, 0, 0 };
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            for (size_t k = 0; k < 4; ++k) {
+                lanes[k] += data[i + k];
+            }
+        }
+        double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < end; ++i) {
+            total += data[i];
+        }
+        return total;
+    }
+
+    double dotBlock(const double* a, const double* b, size_t begin, size_t end) {
+        double lanes[4] = { 0, 0, 0, 0 };
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            for (size_t k = 0; k < 4; ++k) {
+                double product = a[i + k] * b[i + k];
+                lanes[k] += product;
+            }
+        }
+        double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < end; ++i) {
+            double product = a[i] * b[i];
+            total += product;
+        }
+        return total;
+    }
+
+#ifdef SEASHELL_AVX2_KERNELS
+    SEASHELL_TARGET_AVX2 double foldLanes(__m256d lanes) {
+        alignas(32) double parts[4];
+        _mm256_store_pd(parts, lanes);
+        return (parts[0] + parts[1]) + (parts[2] + parts[3]);
+    }
+
+    SEASHELL_TARGET_AVX2 double sumBlockAvx2(const double* data, size_t begin, size_t end) {
+        __m256d lanes = _mm256_setzero_pd();
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            lanes = _mm256_add_pd(lanes, _mm256_loadu_pd(data + i));
+        }
+        double total = foldLanes(lanes);
+        for (; i < end; ++i) {
+            total += data[i];
+        }
+        return total;
+    }
+
+    SEASHELL_TARGET_AVX2 double dotBlockAvx2(const double* a, const double* b, size_t begin, size_t end) {
+        __m256d lanes = _mm256_setzero_pd();
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            // multiply and add stay separate so results match the scalar path
+            lanes = _mm256_add_pd(lanes, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        }
+        double total = foldLanes(lanes);
+        for (; i < end; ++i) {
+            double product = a[i] * b[i];
+            total += product;
+        }
+        return total;
+    }
+
+    SEASHELL_TARGET_AVX2 int64_t sumIntBlockAvx2(const int* data, size_t begin, size_t end) {
+        __m256i lanes = _mm256_setzero_si256();
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            __m128i four = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            lanes = _mm256_add_epi64(lanes, _mm256_cvtepi32_epi64(four));
+        }
+        alignas(32) int64_t parts[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(parts), lanes);
+        int64_t total = parts[0] + parts[1] + parts[2] + parts[3];
+        for (; i < end; ++i) {
+            total += data[i];
+        }
+        return total;
+    }
+#endif
+
+    int64_t sumIntBlock(const int* data, size_t begin, size_t end) {
+        int64_t total = 0;
+        for (size_t i = begin; i < end; ++i) {
+            total += data[i];
+        }
+        return total;
+    }
+
+    // integer sums are exact, so the order only matters for doubles
+    int64_t dotIntBlock(const int* a, const int* b, size_t begin, size_t end) {
+        int64_t total = 0;
+        for (size_t i = begin; i < end; ++i) {
+            total += static_cast<int64_t>(a[i]) * b[i];
+        }
+        return total;
+    }
+
+    template<typename T, typename Pick>
+    T extremeOf(const T* data, size_t n, Pick pick) {
+        return reduceBlocks<T>(n, [&](size_t begin, size_t end) {
+            T best = data[begin];
+            for (size_t i = begin + 1; i < end; ++i) {
+                best = pick(best, data[i]);
+            }
+            return best;
+        }, pick);
+    }
+
+    template<typename T>
+    T smaller(T a, T b) { return b < a ? b : a; }
+
+    template<typename T>
+    T larger(T a, T b) { return a < b ? b : a; }
+
+    double add(double a, double b) { return a + b; }
+    int64_t addInt(int64_t a, int64_t b) { return a + b; }
+}
+
+double sumOf(const double* data, size_t n) {
+    if (n == 0) {
+        return 0.0;
+    }
+#ifdef SEASHELL_AVX2_KERNELS
+    if (CpuFeatures::get().avx2) {
+        return reduceBlocks<double>(n, [&](size_t begin, size_t end) { return sumBlockAvx2(data, begin, end); }, add);
+    }
+#endif
+    return reduceBlocks<double>(n, [&](size_t begin, size_t end) { return sumBlock(data, begin, end); }, add);
+}
+
+int64_t sumOf(const int* data, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+#ifdef SEASHELL_AVX2_KERNELS
+    if (CpuFeatures::get().avx2) {
+        return reduceBlocks<int64_t>(n, [&](size_t begin, size_t end) { return sumIntBlockAvx2(data, begin, end); }, addInt);
+    }
+#endif
+    return reduceBlocks<int64_t>(n, [&](size_t begin, size_t end) { return sumIntBlock(data, begin, end); }, addInt);
+}
+
+double dotOf(const double* a, const double* b, size_t n) {
+    if (n == 0) {
+        return 0.0;
+    }
+#ifdef SEASHELL_AVX2_KERNELS
+    if (CpuFeatures::get().avx2) {
+        return reduceBlocks<double>(n, [&](size_t begin, size_t end) { return dotBlockAvx2(a, b, begin, end); }, add);
+    }
+#endif
+    return reduceBlocks<double>(n, [&](size_t begin, size_t end) { return dotBlock(a, b, begin, end); }, add);
+}
+
+int64_t dotOf(const int* a, const int* b, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    return reduceBlocks<int64_t>(n, [&](size_t begin, size_t end) { return dotIntBlock(a, b, begin, end); }, addInt);
+}
+
+double minOf(const double* data, size_t n) {
+    return extremeOf(data, n, smaller<double>);
+}
+
+int minOf(const int* data, size_t n) {
+    return extremeOf(data, n, smaller<int>);
+}
+
+double maxOf(const double* data, size_t n) {
+    return extremeOf(data, n, larger<double>);
+}
+
+int maxOf(const int* data, size_t n) {
+    return extremeOf(data, n, larger<int>);
+}
@@ -0,0 +1,24 @@
+#ifndef SEASHELLS_REDUCE_H
+#define SEASHELLS_REDUCE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// results depend only on the input, never on the thread count: the input
+// is cut into blocks of a fixed size, every block is reduced in the same
+// lane order with or without AVX2, and block results are combined left to
+// right. Large inputs spread their blocks over ThreadPool::shared()
+
+double sumOf(const double* data, size_t n);
+int64_t sumOf(const int* data, size_t n);
+
+double dotOf(const double* a, const double* b, size_t n);
+int64_t dotOf(const int* a, const int* b, size_t n);
+
+// n must not be zero
+double minOf(const double* data, size_t n);
+int minOf(const int* data, size_t n);
+double maxOf(const double* data, size_t n);
+int maxOf(const int* data, size_t n);
+
+#endif //SEASHELLS_REDUCE_H
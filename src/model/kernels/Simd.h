@@ -0,0 +1,18 @@
+#ifndef SEASHELLS_SIMD_H
+#define SEASHELLS_SIMD_H
+
+// AVX2 kernels are compiled into every x86 build and only called when
+// CpuFeatures reports support, so the binary still runs on older machines.
+// GCC and Clang need the target attribute to emit AVX2 code in a single
+// function; MSVC accepts the intrinsics anywhere
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SEASHELL_AVX2_KERNELS 1
+#define SEASHELL_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#define SEASHELL_AVX2_KERNELS 1
+#define SEASHELL_TARGET_AVX2
+#endif
+
+#endif //SEASHELLS_SIMD_H
@@ -0,0 +1,53 @@
+#ifndef SEASHELLS_SORT_H
+#define SEASHELLS_SORT_H
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include "ThreadPool.h"
+
+// below this many elements per run a single std::sort is faster
+constexpr size_t PARALLEL_SORT_MIN_RUN = 32 * 1024;
+
+// sorts data[0, n) by less. Large inputs are cut into one run per pool
+// thread (a power of two), the runs are sorted concurrently and then merged
+// pairwise, every merge of a round running on its own thread
+template<typename T, typename Less>
+void parallelSort(T* data, size_t n, Less less) {
+    ThreadPool& pool = ThreadPool::shared();
+    size_t runs = 1;
+    while (runs * 2 <= pool.concurrency() && n / (runs * 2) >= PARALLEL_SORT_MIN_RUN) {
+        runs *= 2;
+    }
+    if (runs == 1) {
+        std::sort(data, data + n, less);
+        return;
+    }
+
+    std::vector<size_t> bounds(runs + 1);
+    for (size_t run = 0; run <= runs; ++run) {
+        bounds[run] = n * run / runs;
+    }
+    pool.parallelFor(runs, [&](size_t run) {
+        std::sort(data + bounds[run], data + bounds[run + 1], less);
+    });
+
+    std::vector<T> buffer(n);
+    T* from = data;
+    T* to = buffer.data();
+    for (size_t width = 1; width < runs; width *= 2) {
+        pool.parallelFor(runs / (2 * width), [&](size_t pair) {
+            size_t lo = bounds[pair * 2 * width];
+            size_t mid = bounds[pair * 2 * width + width];
+            size_t hi = bounds[pair * 2 * width + 2 * width];
+            std::merge(std::make_move_iterator(from + lo), std::make_move_iterator(from + mid),
+                std::make_move_iterator(from + mid), std::make_move_iterator(from + hi), to + lo, less);
+        });
+        std::swap(from, to);
+    }
+    if (from != data) {
+        std::move(from, from + n, data);
+    }
+}
+
+#endif //SEASHELLS_SORT_H
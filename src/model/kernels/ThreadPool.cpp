@@ -0,0 +1,155 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <exception>
+
+struct ThreadPool::Batch {
+    const std::function<void(size_t)>* body;
+    size_t count;
+    std::atomic<size_t> finished{ 0 };
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+namespace {
+    // queue index of the current thread in the pool it works for
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentQueue = 0;
+
+    constexpr size_t NO_QUEUE = static_cast<size_t>(-1);
+}
+
+ThreadPool::ThreadPool(size_t workerCount) {
+    queues.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void ThreadPool::run(Task& task) {
+    Batch& batch = *task.batch;
+    try {
+        (*batch.body)(task.index);
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(batch.mutex);
+        if (!batch.error) {
+            batch.error = std::current_exception();
+        }
+    }
+    if (batch.finished.fetch_add(1) + 1 == batch.count) {
+        std::lock_guard<std::mutex> lock(batch.mutex);
+        batch.done.notify_all();
+    }
+}
+
+bool ThreadPool::findTask(size_t self, Task& task) {
+    if (self != NO_QUEUE) {
+        WorkQueue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            pending.fetch_sub(1);
+            return true;
+        }
+    }
+    // victims are tried starting next to us so thieves spread out
+    size_t start = self == NO_QUEUE ? 0 : self + 1;
+    for (size_t i = 0; i < queues.size(); ++i) {
+        WorkQueue& victim = *queues[(start + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            pending.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    currentPool = this;
+    currentQueue = self;
+    while (true) {
+        Task task;
+        if (findTask(self, task)) {
+            run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || pending.load() > 0; });
+        if (stopping && pending.load() == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    auto batch = std::make_shared<Batch>();
+    batch->body = &body;
+    batch->count = count;
+    size_t self = currentPool == this ? currentQueue : NO_QUEUE;
+
+    // deal the tasks round-robin, a worker calling in keeps the first share
+    if (!queues.empty()) {
+        {
+            std::lock_guard<std::mutex> sleepLock(sleepMutex);
+            // counted before any task is visible, a worker taking one right
+            // away must not bring pending below zero
+            pending.fetch_add(count);
+            size_t first = self == NO_QUEUE ? 0 : self;
+            for (size_t q = 0; q < queues.size(); ++q) {
+                WorkQueue& queue = *queues[(first + q) % queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                for (size_t i = q; i < count; i += queues.size()) {
+                    queue.tasks.push_back({ batch, i });
+                }
+            }
+        }
+        wake.notify_all();
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            Task task{ batch, i };
+            run(task);
+        }
+    }
+
+    // help out until every task of the batch has been taken, running
+    // whatever we find; tasks of other batches are fine to run too
+    Task task;
+    while (batch->finished.load() < count && findTask(self, task)) {
+        run(task);
+        task = Task{};
+    }
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&] { return batch->finished.load() == count; });
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SEASHELLS_THREADPOOL_H
+#define SEASHELLS_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads for data-parallel work. Every worker owns a
+// deque of tasks: it takes its own from the front and, once that runs dry,
+// steals from the back of another's, so uneven tasks even out without a
+// central queue. The calling thread always takes part in its own work, so
+// a task may itself call parallelFor without starving the pool
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // one worker per hardware thread besides the caller
+    static ThreadPool& shared();
+
+    // threads that can run tasks at once, the caller included
+    size_t concurrency() const { return workers.size() + 1; }
+
+    // runs body(0) .. body(count - 1) and returns when all have finished;
+    // the first exception a task throws is rethrown here
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    struct Batch;
+
+    struct Task {
+        std::shared_ptr<Batch> batch;
+        size_t index;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t self);
+    // pops from queue self if it is ours, then steals from the others
+    bool findTask(size_t self, Task& task);
+    static void run(Task& task);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues; // one per worker
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending{ 0 }; // queued tasks not yet taken
+    bool stopping = false;
+};
+
+#endif //SEASHELLS_THREADPOOL_H
@@ -3,19 +3,22 @@
 #include <stdexcept>
 #include "Lexer.h"
 
+Token Lexer::next() {
+	try {
+		return nextToken();
+	}
+	catch (const std::exception& e) {
+		throw LexError("line " + std::to_string(line) + ", column "
+			+ std::to_string(column) + ": " + e.what());
+	}
+}
+
 std::vector<Token> Lexer::tokenize() {
 	std::vector<Token> tokens;
 
-	while (!isAtEnd()) {
-		try {
-			tokens.push_back(nextToken());
-		}
-		catch (const std::exception& e) {
-			throw std::runtime_error("line " + std::to_string(line) + ", column "
-				+ std::to_string(column) + ": " + e.what());
-		}
-	}
-	tokens.emplace_back(TokenType::EndOfFile, "", line, column);
+	do {
+		tokens.push_back(next());
+	} while (tokens.back().type != TokenType::EndOfFile);
 	return tokens;
 }
 
@@ -77,13 +80,16 @@ Token Lexer::identifier() {
 
 	// check if keyword
 	static const std::unordered_set<std::string> keywords = {
-		"int", "double", "bool", "string",
-		"if", "void", "else", "while", "for",
+		"int", "double", "bool", "string", "map", "matrix", "struct",
+		"if", "void", "else", "while", "for", "parallel",
 		"return", "true", "false", "break", "continue"
 	};
 
-	TokenType type = keywords.count(id) ? TokenType::Keyword : TokenType::Identifier;
-	return Token(type, id, line, startColumn);
+	if (keywords.count(id)) {
+		return Token(TokenType::Keyword, id, line, startColumn);
+	}
+	SymbolId symbol = SymbolTable::intern(id);
+	return Token(TokenType::Identifier, std::move(id), line, startColumn, symbol);
 }
 
 Token Lexer::makeToken(TokenType type, std::string value) {
@@ -140,6 +146,8 @@ Token Lexer::nextToken() {
 	case '}': return { TokenType::RightBrace, "}", line, startColumn };
 	case ';': return { TokenType::Semicolon, ";", line, startColumn };
 	case ',': return { TokenType::Comma, ",", line, startColumn };
+	case ':': return { TokenType::Colon, ":", line, startColumn };
+	case '.': return { TokenType::Dot, ".", line, startColumn };
 	case '*': return { TokenType::Operator, "*", line, startColumn };
 	case '/': return { TokenType::Operator, "/", line, startColumn };
 	case '"': return string();
@@ -1,7 +1,14 @@
 #pragma once
 #include <vector>
+#include <stdexcept>
 #include "Token.h"
 
+// raised for malformed input at the character level, carries line/column info
+class LexError : public std::runtime_error {
+public:
+	explicit LexError(const std::string& message) : std::runtime_error(message) {}
+};
+
 class Lexer {
 private:
 	Token nextToken();
@@ -24,8 +31,10 @@ private:
 	int column;
 
 public:
-	Lexer(std::string source) : source(source), current(0), line(1), column(1) {};
+	Lexer(std::string source, int startLine = 1) : source(source), current(0), line(startLine), column(1) {};
 
+	// pulls the next token, returns EndOfFile once the source is exhausted
+	Token next();
 	std::vector<Token> tokenize();
 };
 
@@ -0,0 +1,39 @@
+#include "ParseCache.h"
+
+std::shared_ptr<ParseCache::Program> ParseCache::find(const std::string& source) {
+	auto it = index.find(std::hash<std::string>{}(source));
+	// the text is compared as well so a hash collision is just a miss
+	if (it == index.end() || it->second->source != source) {
+		missCount++;
+		return nullptr;
+	}
+	hitCount++;
+	entries.splice(entries.begin(), entries, it->second);
+	return it->second->program;
+}
+
+void ParseCache::insert(const std::string& source, std::shared_ptr<Program> program) {
+	if (capacity == 0 || source.size() > MAX_SOURCE_LENGTH) {
+		return;
+	}
+
+	size_t hash = std::hash<std::string>{}(source);
+	auto it = index.find(hash);
+	if (it != index.end()) {
+		entries.erase(it->second);
+		index.erase(it);
+	}
+
+	entries.push_front({ hash, source, std::move(program) });
+	index[hash] = entries.begin();
+
+	if (entries.size() > capacity) {
+		index.erase(entries.back().hash);
+		entries.pop_back();
+	}
+}
+
+void ParseCache::clear() {
+	entries.clear();
+	index.clear();
+}
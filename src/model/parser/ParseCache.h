@@ -0,0 +1,40 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ast/ASTNode.h"
+
+// LRU cache from input text to its parsed top-level statements, so re-running
+// the same input skips the parser entirely
+class ParseCache {
+public:
+	using Program = std::vector<std::unique_ptr<ASTNode>>;
+
+	// larger inputs are streamed and dropped rather than kept around
+	static constexpr size_t MAX_SOURCE_LENGTH = 64 * 1024;
+
+	explicit ParseCache(size_t capacity = 64) : capacity(capacity) {}
+
+	std::shared_ptr<Program> find(const std::string& source);
+	void insert(const std::string& source, std::shared_ptr<Program> program);
+	void clear();
+
+	size_t size() const { return entries.size(); }
+	size_t hits() const { return hitCount; }
+	size_t misses() const { return missCount; }
+
+private:
+	struct Entry {
+		size_t hash;
+		std::string source;
+		std::shared_ptr<Program> program;
+	};
+
+	size_t capacity;
+	std::list<Entry> entries; // most recently used first
+	std::unordered_map<size_t, std::list<Entry>::iterator> index;
+	size_t hitCount = 0;
+	size_t missCount = 0;
+};
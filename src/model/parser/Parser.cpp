@@ -1,27 +1,58 @@
 #include "Parser.h"
 #include "Lexer.h"
 #include <iostream>
+#include <unordered_map>
 
 std::unordered_set<std::string> reservedKeywords = {
-		"if", "else", "while", "return", "for", "true", "false", "break", "continue"
+		"if", "else", "while", "return", "for", "true", "false", "break", "continue", "struct", "parallel"
 };
 
 std::unique_ptr<ASTNode> Parser::parse(const std::string& input) {
-	Lexer lexer(input);
-	tokens = lexer.tokenize();
-	current = 0;
+	begin(input);
 	return program();
 }
 
+void Parser::begin(const std::string& input) {
+	lexer = std::make_unique<Lexer>(input);
+	pending.clear();
+	pendingPos = 0;
+	head = 0;
+	buffered = 0;
+	last = Token();
+	halted = false;
+	error.clear();
+}
+
+void Parser::begin(std::vector<Token> tokens) {
+	lexer.reset();
+	pending = std::move(tokens);
+	pendingPos = 0;
+	head = 0;
+	buffered = 0;
+	last = Token();
+	halted = false;
+	error.clear();
+}
+
+std::unique_ptr<ASTNode> Parser::nextStatement() {
+	if (halted || isAtEnd()) {
+		return nullptr;
+	}
+	std::unique_ptr<ASTNode> decl = declaration();
+	// a statement nested in a block may have failed while the block itself
+	// parsed, the whole top-level statement is dropped then
+	if (decl == nullptr || !error.empty()) {
+		recordError("unexpected '" + peek().value + "'");
+		halted = true; // stop at the first unparsable statement
+		return nullptr;
+	}
+	return decl;
+}
+
 std::unique_ptr<ASTNode> Parser::program() {
 	std::vector<std::unique_ptr<ASTNode>> statements;
 	// parse until EOF or all declarations consumed
-	while (!isAtEnd()) {
-		std::unique_ptr<ASTNode> decl = declaration();
-		if (decl == nullptr) {
-			break;
-		}
-
+	while (std::unique_ptr<ASTNode> decl = nextStatement()) {
 		statements.push_back(std::move(decl));
 	}
 	return std::make_unique<BlockNode>(std::move(statements), false); // don't create scope for global block
@@ -29,6 +60,12 @@ std::unique_ptr<ASTNode> Parser::program() {
 
 std::unique_ptr<ASTNode> Parser::declaration() {
 	try {
+		if (check(TokenType::Keyword) && peek().value == "struct") {
+			return structDeclaration();
+		}
+		if (atStructVariable()) {
+			return structVariableDeclaration(advance());
+		}
 		if (check(TokenType::Keyword) &&
 			reservedKeywords.find(peek().value) == reservedKeywords.end()) {
 
@@ -47,7 +84,11 @@ std::unique_ptr<ASTNode> Parser::declaration() {
 		}
 		return statement();
 	}
-	catch (const std::runtime_error& error) {
+	catch (const LexError&) {
+		throw; // malformed characters are reported, not skipped
+	}
+	catch (const std::runtime_error& e) {
+		recordError(e.what());
 		synchronize();
 		return nullptr;
 	}
@@ -58,63 +99,33 @@ std::unique_ptr<ASTNode> Parser::variableDeclaration(Type type, Token name) {
 
 	do {
 		std::unique_ptr<ASTNode> initializer = nullptr;
+		Type declType = type;
 		// handles arrays, else case handles regulars
 		if (match(TokenType::LeftBracket)) {
-			Type arrayType = type;
-			type = Type::ARRAY;
+			declType = Type::ARRAY;
 			std::unique_ptr<ASTNode> size = nullptr;
 
-			int specifiedSize = 5; // default size
-
 			if (!check(TokenType::RightBracket)) {
 				size = expression();
-				specifiedSize = std::stoi(size->toString());
 			}
 			consume(TokenType::RightBracket, "expect ']' after array size if any");
 
 			if (match(TokenType::Operator) && previous().value == "=") {
 				initializer = expression();
-				auto* arrayNode = dynamic_cast<ArrayNode*>(initializer.get());
-
-				// check if the initializer is an ArrayNode and validate its size
-				if (arrayNode->getSize() > specifiedSize) {
-					throw std::runtime_error("array initializer size " +
-						std::to_string(arrayNode->getSize()) +
-						" exceeds specified size " +
-						std::to_string(specifiedSize));
-				}
 			}
-			else {
-				// create default array with specified size
-				std::vector<std::unique_ptr<ASTNode>> elements;
-				for (int i = 0; i < specifiedSize; i++) {
-					switch (arrayType) {
-					case Type::INT:
-						elements.push_back(std::make_unique<LiteralNode>(0));
-						break;
-					case Type::DOUBLE:
-						elements.push_back(std::make_unique<LiteralNode>(0.0));
-						break;
-					case Type::BOOL:
-						elements.push_back(std::make_unique<LiteralNode>(false));
-						break;
-					case Type::STRING:
-						elements.push_back(std::make_unique<LiteralNode>(std::string("")));
-						break;
-					default:
-						throw std::runtime_error("invalid type for array declaration");
-					}
-				}
-				initializer = std::make_unique<ArrayNode>(std::move(elements), arrayType);
+			else if (size == nullptr) {
+				size = std::make_unique<LiteralNode>(5); // default size
 			}
 
+			// size is evaluated at runtime, storage is allocated in one step
+			initializer = std::make_unique<ArrayAllocNode>(type, std::move(size), std::move(initializer));
 		}
 		else {
 			if (match(TokenType::Operator) && previous().value == "=") {
 				initializer = expression();
 			}
 			else {
-				switch (type) {
+				switch (declType) {
 				case Type::INT:
 					initializer = std::make_unique<LiteralNode>(0);
 					break;
@@ -125,14 +136,18 @@ std::unique_ptr<ASTNode> Parser::variableDeclaration(Type type, Token name) {
 					initializer = std::make_unique<LiteralNode>(false);
 					break;
 				case Type::STRING:
-					initializer = std::make_unique<LiteralNode>("");
+					initializer = std::make_unique<LiteralNode>(std::string(""));
+					break;
+				case Type::MAP:
+				case Type::MATRIX:
+					initializer = std::make_unique<LiteralNode>(Value::defaultFor(declType));
 					break;
 				default:
 					throw std::runtime_error("invalid type for variable declaration");
 				}
 			}
 		}
-		declarations.push_back(std::make_unique<AssignmentNode>(name.value, type, std::move(initializer)));
+		declarations.push_back(std::make_unique<AssignmentNode>(name.symbol, declType, std::move(initializer)));
 
 	} while (match(TokenType::Comma) && (name = consume(TokenType::Identifier, "expect additional variable name after ','"), true));
 
@@ -145,10 +160,63 @@ std::unique_ptr<ASTNode> Parser::variableDeclaration(Type type, Token name) {
 	}
 }
 
+std::unique_ptr<ASTNode> Parser::structDeclaration() {
+	consume(TokenType::Keyword, "expect 'struct'");
+	Token name = consume(TokenType::Identifier, "expect struct name");
+	consume(TokenType::LeftBrace, "expect '{' after struct name");
+
+	// offsets follow declaration order, the layout is fixed from here on
+	std::vector<std::pair<SymbolId, Type>> fields;
+	while (!check(TokenType::RightBrace)) {
+		Type fieldType = tokenToType(consume(TokenType::Keyword, "expect field type"));
+		Token field = consume(TokenType::Identifier, "expect field name");
+		consume(TokenType::Semicolon, "expect ';' after field");
+		fields.emplace_back(field.symbol, fieldType);
+	}
+	consume(TokenType::RightBrace, "expect '}' after struct fields");
+	match(TokenType::Semicolon);
+	return std::make_unique<StructDeclNode>(name.symbol, std::move(fields));
+}
+
+std::unique_ptr<ASTNode> Parser::structVariableDeclaration(Token structName) {
+	std::vector<std::unique_ptr<ASTNode>> declarations;
+	Token name = consume(TokenType::Identifier, "expect variable name after struct type");
+
+	do {
+		bool array = false;
+		std::unique_ptr<ASTNode> size = nullptr;
+		std::unique_ptr<ASTNode> initializer = nullptr;
+		if (match(TokenType::LeftBracket)) {
+			array = true;
+			if (!check(TokenType::RightBracket)) {
+				size = expression();
+			}
+			consume(TokenType::RightBracket, "expect ']' after array size if any");
+		}
+		if (match(TokenType::Operator) && previous().value == "=") {
+			initializer = expression();
+		}
+		else if (array && size == nullptr) {
+			size = std::make_unique<LiteralNode>(5); // default size
+		}
+
+		auto value = std::make_unique<StructAllocNode>(structName.symbol, array, std::move(size), std::move(initializer));
+		declarations.push_back(std::make_unique<AssignmentNode>(name.symbol,
+			array ? Type::STRUCT_ARRAY : Type::STRUCT, std::move(value)));
+
+	} while (match(TokenType::Comma) && (name = consume(TokenType::Identifier, "expect additional variable name after ','"), true));
+
+	consume(TokenType::Semicolon, "expect ';' after variable declaration");
+	if (declarations.size() == 1) {
+		return std::move(declarations[0]);
+	}
+	return std::make_unique<BlockNode>(std::move(declarations), false); // grouping only
+}
+
 std::unique_ptr<ASTNode> Parser::functionDeclaration(Type returnType, Token name) {
 	// we already consumed return type and function name
 	consume(TokenType::LeftParen, "expect '(' after function name");
-	std::vector<std::pair<std::string, Type>> parameters;
+	std::vector<std::pair<SymbolId, Type>> parameters;
 	std::vector<std::unique_ptr<ASTNode>> arguments;
 	bool isCall = false;
 
@@ -158,7 +226,7 @@ std::unique_ptr<ASTNode> Parser::functionDeclaration(Type returnType, Token name
 				// func decl
 				Token paramType = consume(TokenType::Keyword, "expect parameter type");
 				Token paramName = consume(TokenType::Identifier, "expect parameter name");
-				parameters.emplace_back(paramName.value, tokenToType(paramType));
+				parameters.emplace_back(paramName.symbol, tokenToType(paramType));
 			}
 			else {
 				// func call
@@ -171,12 +239,27 @@ std::unique_ptr<ASTNode> Parser::functionDeclaration(Type returnType, Token name
 		if (isCall) {
 			consume(TokenType::RightParen, "expect ')' after parameters");
 			consume(TokenType::Semicolon, "expect ';' after func call");
-			return std::make_unique<CallNode>(name.value, std::move(arguments));
+			return std::make_unique<CallNode>(name.symbol, std::move(arguments));
 		}
 	}
 	consume(TokenType::RightParen, "expect ')' after parameters");
+	if (lazyFunctionBodies) {
+		return std::make_unique<FunctionNode>(name.symbol, parameters, returnType, skipBlock());
+	}
 	auto body = block();
-	return std::make_unique<FunctionNode>(name.value, parameters, returnType, std::move(body));
+	return std::make_unique<FunctionNode>(name.symbol, parameters, returnType, std::move(body));
+}
+
+std::unique_ptr<ASTNode> Parser::parseFunctionBody(std::vector<Token> tokens) {
+	begin(std::move(tokens));
+	auto body = block();
+	if (!error.empty()) {
+		throw std::runtime_error(error);
+	}
+	if (!isAtEnd()) {
+		throw std::runtime_error("unexpected tokens after function body");
+	}
+	return body;
 }
 
 std::unique_ptr<ASTNode> Parser::statement() {
@@ -185,12 +268,15 @@ std::unique_ptr<ASTNode> Parser::statement() {
 		if (peek().value == "while") return whileStatement();
 		if (peek().value == "return") return returnStatement();
 		if (peek().value == "for") return forStatement();
+		if (peek().value == "parallel") return parallelForStatement();
 		if (peek().value == "break") return breakStatement();
 		if (peek().value == "continue") return continueStatement();
 
 		return declaration();
 	}
 
+	if (atStructVariable()) return declaration();
+
 	// parse block
 	if (check(TokenType::LeftBrace)) return block();
 	return expressionStatement(); // parse as expression statement otherwise
@@ -218,6 +304,20 @@ std::unique_ptr<ASTNode> Parser::forStatement() {
 	consume(TokenType::Keyword, "expect 'for'");
 	consume(TokenType::LeftParen, "expect '(' after 'for'");
 
+	// for (type name : sequence), the type may also name a struct
+	if ((check(TokenType::Keyword) || check(TokenType::Identifier)) && peek(1).type == TokenType::Identifier &&
+		peek(2).type == TokenType::Colon) {
+		bool structElement = check(TokenType::Identifier);
+		Type elemType = structElement ? Type::STRUCT : tokenToType(peek());
+		advance();
+		SymbolId variable = advance().symbol;
+		advance(); // ':'
+		auto sequence = expression();
+		consume(TokenType::RightParen, "expect ')' after foreach sequence");
+		auto body = statement();
+		return std::make_unique<ForEachNode>(elemType, variable, std::move(sequence), std::move(body));
+	}
+
 	std::unique_ptr<ASTNode> init = nullptr;
 	if (match(TokenType::Semicolon)) {
 		init = nullptr;
@@ -254,6 +354,28 @@ std::unique_ptr<ASTNode> Parser::forStatement() {
 	);
 }
 
+std::unique_ptr<ASTNode> Parser::parallelForStatement() {
+	consume(TokenType::Keyword, "expect 'parallel'");
+
+	// optional list of variables the iterations sum into
+	std::vector<SymbolId> reductions;
+	if (match(TokenType::LeftParen)) {
+		do {
+			reductions.push_back(consume(TokenType::Identifier, "expect reduction variable").symbol);
+		} while (match(TokenType::Comma));
+		consume(TokenType::RightParen, "expect ')' after reduction variables");
+	}
+
+	if (!check(TokenType::Keyword) || peek().value != "for") {
+		throw std::runtime_error("expect 'for' after 'parallel'");
+	}
+	auto loop = forStatement();
+	if (loop->getNodeType() != ASTNode::NodeType::For) {
+		throw std::runtime_error("parallel needs a counting for loop");
+	}
+	return std::make_unique<ParallelForNode>(std::move(loop), std::move(reductions));
+}
+
 std::unique_ptr<ASTNode> Parser::whileStatement() {
 	consume(TokenType::Keyword, "expect 'while'");
 	consume(TokenType::LeftParen, "expect '(' after 'while'");
@@ -297,7 +419,7 @@ std::unique_ptr<ASTNode> Parser::functionCall(const Token& id) {
 	}
 
 	consume(TokenType::RightParen, "expect '(' after arguments");
-	return std::make_unique<CallNode>(id.value, std::move(args));
+	return std::make_unique<CallNode>(id.symbol, std::move(args));
 }
 
 std::unique_ptr<ASTNode> Parser::block() {
@@ -319,6 +441,23 @@ std::unique_ptr<ASTNode> Parser::block() {
 	return std::make_unique<BlockNode>(std::move(statements), true); // create scope for explicit blocks
 }
 
+// pre-parse mode: only checks that braces balance and keeps the tokens
+std::vector<Token> Parser::skipBlock() {
+	std::vector<Token> body;
+	body.push_back(consume(TokenType::LeftBrace, "expect '{' before block."));
+
+	int depth = 1;
+	while (depth > 0) {
+		if (isAtEnd()) {
+			throw std::runtime_error("expect '}' after block");
+		}
+		if (check(TokenType::LeftBrace)) depth++;
+		else if (check(TokenType::RightBrace)) depth--;
+		body.push_back(advance());
+	}
+	return body;
+}
+
 std::unique_ptr<ASTNode> Parser::expressionStatement() {
 	try {
 		auto expr = expression();
@@ -330,162 +469,181 @@ std::unique_ptr<ASTNode> Parser::expressionStatement() {
 
 		return expr;
 	}
+	catch (const LexError&) {
+		throw; // already carries its position
+	}
 	catch (const std::exception& e) {
+		recordError(e.what());
 		return nullptr;
 	}
 }
 
-std::unique_ptr<ASTNode> Parser::expression() {
-	auto result = assignment();
-	return result;
-}
-
-std::unique_ptr<ASTNode> Parser::assignment() {
-	auto expr = logicalOr();
-
-	if (check(TokenType::Operator) && peek().value == "=") {
-		advance();
-		if (expr->getNodeType() == ASTNode::NodeType::Variable) {
-			auto varNode = dynamic_cast<VariableNode*>(expr.get());
-			auto value = assignment();
-			return std::make_unique<AssignmentNode>(varNode->toString(), std::move(value));
+namespace {
+	// binding strength of infix operators, higher binds tighter
+	constexpr int ASSIGNMENT_PRECEDENCE = 1;
+	constexpr int UNARY_PRECEDENCE = 8;
+
+	struct InfixRule {
+		Operator op;
+		int precedence;
+	};
+
+	const std::unordered_map<std::string, InfixRule> infixRules = {
+		{ "||", { Operator::Or, 2 } },
+		{ "&&", { Operator::And, 3 } },
+		{ "==", { Operator::Equal, 4 } },
+		{ "!=", { Operator::NotEqual, 4 } },
+		{ "<", { Operator::Less, 5 } },
+		{ ">", { Operator::Greater, 5 } },
+		{ "<=", { Operator::LessEqual, 5 } },
+		{ ">=", { Operator::GreaterEqual, 5 } },
+		{ "+", { Operator::Add, 6 } },
+		{ "-", { Operator::Subtract, 6 } },
+		{ "*", { Operator::Multiply, 7 } },
+		{ "/", { Operator::Divide, 7 } },
+	};
+
+	const std::unordered_map<std::string, Operator> prefixRules = {
+		{ "!", Operator::LogicalNot },
+		{ "-", Operator::Negate },
+		{ "++", Operator::PreIncrement },
+		{ "--", Operator::PreDecrement },
+	};
+
+	// operator waiting on the explicit stack for its operands
+	struct PendingOperator {
+		enum class Kind { Prefix, Infix, Assignment, Group } kind;
+		Operator op;
+		int precedence;
+	};
+
+	void reduce(std::vector<std::unique_ptr<ASTNode>>& operands, const PendingOperator& pending) {
+		std::unique_ptr<ASTNode> right = std::move(operands.back());
+		operands.pop_back();
+
+		if (pending.kind == PendingOperator::Kind::Prefix) {
+			operands.push_back(std::make_unique<UnaryOpNode>(pending.op, std::move(right)));
+			return;
 		}
-		else if (expr->getNodeType() == ASTNode::NodeType::ArrayAccess) {
-			auto arrayNode = dynamic_cast<ArrayAccessNode*>(expr.get());
-			auto value = assignment();
-			return std::make_unique<AssignmentNode>(arrayNode->getName(), std::move(value), std::move(arrayNode->getIndex()));
-		}
-		throw std::runtime_error("invalid assignment target");
-	}
-	return expr;
-}
-
-std::unique_ptr<ASTNode> Parser::logicalOr() {
-	auto expr = logicalAnd();
 
-	while (check(TokenType::Operator) && peek().value == "||") {
+		std::unique_ptr<ASTNode> left = std::move(operands.back());
+		operands.pop_back();
 
-		advance();
-		Token op = previous();
-		auto right = logicalAnd();
-		expr = std::make_unique<BinOpNode>(Operator::Or, std::move(expr), std::move(right));
-	}
-	return expr;
-}
-
-std::unique_ptr<ASTNode> Parser::logicalAnd() {
-	auto expr = equality();
-
-	while (check(TokenType::Operator) && peek().value == "&&") {
+		if (pending.kind == PendingOperator::Kind::Infix) {
+			operands.push_back(std::make_unique<BinOpNode>(pending.op, std::move(left), std::move(right)));
+			return;
+		}
 
-		advance();
-		Token op = previous();
-		auto right = equality();
-		expr = std::make_unique<BinOpNode>(Operator::And, std::move(expr), std::move(right));
+		// assignment, the left operand has to be something we can store into
+		if (left->getNodeType() == ASTNode::NodeType::Variable) {
+			operands.push_back(std::make_unique<AssignmentNode>(static_cast<VariableNode*>(left.get())->getSymbol(), std::move(right)));
+		}
+		else if (left->getNodeType() == ASTNode::NodeType::ArrayAccess) {
+			auto arrayNode = dynamic_cast<ArrayAccessNode*>(left.get());
+			operands.push_back(std::make_unique<AssignmentNode>(arrayNode->getSymbol(), std::move(right),
+				std::move(arrayNode->getIndex()), std::move(arrayNode->getColumn())));
+		}
+		else if (left->getNodeType() == ASTNode::NodeType::FieldAccess) {
+			auto fieldNode = static_cast<FieldAccessNode*>(left.get());
+			operands.push_back(std::make_unique<FieldAssignmentNode>(std::move(fieldNode->getObject()),
+				fieldNode->getField(), std::move(right)));
+		}
+		else {
+			throw std::runtime_error("invalid assignment target");
+		}
 	}
-	return expr;
 }
 
-std::unique_ptr<ASTNode> Parser::equality() {
-	auto expr = comparison();
-
-	while (check(TokenType::Operator) &&
-		(peek().value == "==" || peek().value == "!=")) {
-
-		advance();
-		Token op = previous();
-		auto right = comparison();
-		expr = std::make_unique<BinOpNode>(
-			op.value == "==" ? Operator::Equal : Operator::NotEqual,
-			std::move(expr), std::move(right)
-		);
-	}
-	return expr;
-}
-
-std::unique_ptr<ASTNode> Parser::comparison() {
-	auto expr = term();
-	while (check(TokenType::Operator) && (
-		peek().value == "<" || peek().value == ">" ||
-		peek().value == "<=" || peek().value == ">="))
-	{
-		advance();
-		Token op = previous();
-		auto right = term();
-		Operator binOp;
-
-		if (op.value == "<") binOp = Operator::Less;
-		else if (op.value == ">") binOp = Operator::Greater;
-		else if (op.value == "<=") binOp = Operator::LessEqual;
-		else binOp = Operator::GreaterEqual;
+// precedence climbing over an explicit operator stack, so the native stack
+// depth no longer grows with the number of precedence levels or parentheses
+std::unique_ptr<ASTNode> Parser::expression() {
+	std::vector<std::unique_ptr<ASTNode>> operands;
+	std::vector<PendingOperator> operators;
+	operands.reserve(8);
+	operators.reserve(8);
+	size_t openGroups = 0;
+
+	while (true) {
+		// prefix operators and opening parentheses ahead of the operand
+		while (true) {
+			if (match(TokenType::LeftParen)) {
+				operators.push_back({ PendingOperator::Kind::Group, Operator::Add, 0 });
+				openGroups++;
+			}
+			else if (check(TokenType::Operator)) {
+				auto rule = prefixRules.find(peek().value);
+				if (rule == prefixRules.end()) {
+					throw std::runtime_error("invalid unary operator");
+				}
+				advance();
+				operators.push_back({ PendingOperator::Kind::Prefix, rule->second, UNARY_PRECEDENCE });
+			}
+			else {
+				break;
+			}
+		}
 
-		expr = std::make_unique<BinOpNode>(binOp, std::move(expr), std::move(right));
-	}
-	return expr;
-}
+		operands.push_back(postfix(primary()));
 
-std::unique_ptr<ASTNode> Parser::term() {
-	auto expr = factor();
+		// close any parenthesized groups that end right after the operand
+		while (openGroups > 0 && match(TokenType::RightParen)) {
+			while (operators.back().kind != PendingOperator::Kind::Group) {
+				reduce(operands, operators.back());
+				operators.pop_back();
+			}
+			operators.pop_back();
+			openGroups--;
+			operands.back() = postfix(std::move(operands.back()));
+		}
 
-	while (check(TokenType::Operator)) {
-		Token op = peek();
+		if (!check(TokenType::Operator)) {
+			break;
+		}
 
-		if (op.value == "+" || op.value == "-") {
-			advance();
-			auto right = factor();
-			expr = std::make_unique<BinOpNode>(
-				op.value == "+" ? Operator::Add : Operator::Subtract,
-				std::move(expr), std::move(right));
+		PendingOperator next;
+		if (peek().value == "=") {
+			next = { PendingOperator::Kind::Assignment, Operator::Add, ASSIGNMENT_PRECEDENCE };
 		}
 		else {
-			break;
+			auto rule = infixRules.find(peek().value);
+			if (rule == infixRules.end()) {
+				break;
+			}
+			next = { PendingOperator::Kind::Infix, rule->second.op, rule->second.precedence };
 		}
-	}
-	return expr;
-}
-
-std::unique_ptr<ASTNode> Parser::factor() {
-	auto expr = unary();
-
-	while (peek().type == TokenType::Operator &&
-		(peek().value == "*" || peek().value == "/")) {
 		advance();
-		Token op = previous();
-		auto right = primary();
-		expr = std::make_unique<BinOpNode>(
-			op.value == "*" ? Operator::Multiply : Operator::Divide,
-			std::move(expr), std::move(right));
-	}
-	return expr;
-}
 
-std::unique_ptr<ASTNode> Parser::unary() {
-	if (check(TokenType::Operator)) {
-		Token op = advance();
-		std::unique_ptr<ASTNode> right = unary();
-		Operator unaryOp;
-
-		if (op.value == "!") unaryOp = Operator::LogicalNot;
-		else if (op.value == "-") unaryOp = Operator::Negate;
-		else if (op.value == "++") unaryOp = Operator::PreIncrement;
-		else if (op.value == "--") unaryOp = Operator::PreDecrement;
-		else throw std::runtime_error("invalid unary operator");
+		// assignment is right associative, everything else left associative
+		bool rightAssoc = next.kind == PendingOperator::Kind::Assignment;
+		while (!operators.empty() && operators.back().kind != PendingOperator::Kind::Group &&
+			(operators.back().precedence > next.precedence ||
+				(operators.back().precedence == next.precedence && !rightAssoc))) {
+			reduce(operands, operators.back());
+			operators.pop_back();
+		}
+		operators.push_back(next);
+	}
 
-		return std::make_unique<UnaryOpNode>(unaryOp, std::move(right));
+	if (openGroups > 0) {
+		throw std::runtime_error("expect ')' after expression");
 	}
+	while (!operators.empty()) {
+		reduce(operands, operators.back());
+		operators.pop_back();
+	}
+	return std::move(operands.back());
+}
 
-	// check for post increment or decrement
-	std::unique_ptr<ASTNode> expr = primary();
+std::unique_ptr<ASTNode> Parser::postfix(std::unique_ptr<ASTNode> operand) {
 	if (check(TokenType::Operator)) {
-		Token op = peek();
-		if (op.value == "++" || op.value == "--") {
+		const std::string& op = peek().value;
+		if (op == "++" || op == "--") {
+			Operator unaryOp = (op == "++") ? Operator::PostIncrement : Operator::PostDecrement;
 			advance();
-			Operator unaryOp = (op.value == "++") ? Operator::PostIncrement : Operator::PostDecrement;
-			return std::make_unique<UnaryOpNode>(unaryOp, std::move(expr));
+			return std::make_unique<UnaryOpNode>(unaryOp, std::move(operand));
 		}
 	}
-	// parse the operand if no unary operator
-	return expr;
+	return operand;
 }
 
 std::unique_ptr<ASTNode> Parser::primary() {
@@ -539,24 +697,39 @@ std::unique_ptr<ASTNode> Parser::primary() {
 	if (match(TokenType::Identifier)) {
 		auto id = previous();
 		if (match(TokenType::LeftParen)) {
-			return functionCall(id);
+			return fieldAccess(functionCall(id));
 		}
 		if (match(TokenType::LeftBracket)) {
 			auto index = expression();
 			consume(TokenType::RightBracket, "expect ']' after array access index");
-			return std::make_unique<ArrayAccessNode>(id.value, std::move(index));
+			std::unique_ptr<ASTNode> column = nullptr;
+			if (match(TokenType::LeftBracket)) {
+				column = expression();
+				consume(TokenType::RightBracket, "expect ']' after column index");
+			}
+			return fieldAccess(std::make_unique<ArrayAccessNode>(id.symbol, std::move(index), std::move(column)));
 		}
-		return std::make_unique<VariableNode>(id.value);
-	}
-
-	if (match(TokenType::LeftParen)) {
-		auto expr = expression();
-		consume(TokenType::RightParen, "expect ')' after expression");
-		return expr;
+		return fieldAccess(std::make_unique<VariableNode>(id.symbol));
 	}
 
 	throw std::runtime_error("expect expression");
 }
+
+std::unique_ptr<ASTNode> Parser::fieldAccess(std::unique_ptr<ASTNode> object) {
+	while (match(TokenType::Dot)) {
+		Token field = consume(TokenType::Identifier, "expect field name after '.'");
+		object = std::make_unique<FieldAccessNode>(std::move(object), field.symbol);
+	}
+	return object;
+}
+// only the first error is kept, it is the one closest to the actual mistake
+void Parser::recordError(const std::string& message) {
+	if (error.empty()) {
+		const Token& at = peek();
+		error = "line " + std::to_string(at.line) + ", column " + std::to_string(at.column) + ": " + message;
+	}
+}
+
 void Parser::synchronize() {
 	advance();
 
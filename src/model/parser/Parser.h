@@ -1,65 +1,116 @@
 #pragma once
 #include <string>
 #include <iostream>
+#include <array>
 #include "../../model/ast/ASTNode.h"
+#include "Lexer.h"
 #include "Token.h"
 
 class Parser {
 public:
 	std::unique_ptr<ASTNode> parse(const std::string& input);
 
+	// streaming interface: begin() then pull one top-level statement at a time,
+	// nextStatement() returns nullptr once the input is exhausted or unparsable
+	void begin(const std::string& input);
+	void begin(std::vector<Token> tokens); // already lexed input
+	std::unique_ptr<ASTNode> nextStatement();
+	// true if the last input stopped at a statement that failed to parse
+	bool stoppedEarly() const { return halted; }
+	// why it stopped, with the line and column it stopped at
+	const std::string& errorMessage() const { return error; }
+
+	// when enabled, function bodies are only brace-checked and kept as tokens
+	void setLazyFunctionBodies(bool lazy) { lazyFunctionBodies = lazy; }
+	std::unique_ptr<ASTNode> parseFunctionBody(std::vector<Token> tokens);
+
 private:
-	std::vector<Token> tokens;
-	size_t current = 0;
+	// tokens are pulled from the lexer on demand into a small ring buffer,
+	// so only the lookahead window is ever held in memory
+	static constexpr size_t LOOKAHEAD = 4;
+
+	std::unique_ptr<Lexer> lexer;
+	std::vector<Token> pending; // token source when no lexer is attached
+	size_t pendingPos = 0;
+	std::array<Token, LOOKAHEAD> lookahead;
+	size_t head = 0;
+	size_t buffered = 0;
+	Token last;
+	bool halted = false;
+	std::string error; // first parse error of the input, empty if none
+	bool lazyFunctionBodies = true;
 
 	std::unique_ptr<ASTNode> program();
 	std::unique_ptr<ASTNode> declaration();
 	std::unique_ptr<ASTNode> variableDeclaration(Type type, Token name);
 	std::unique_ptr<ASTNode> functionDeclaration(Type returnType, Token name);
+	std::unique_ptr<ASTNode> structDeclaration();
+	std::unique_ptr<ASTNode> structVariableDeclaration(Token structName);
 	std::unique_ptr<ASTNode> statement();
 	std::unique_ptr<ASTNode> ifStatement();
 	std::unique_ptr<ASTNode> forStatement();
+	std::unique_ptr<ASTNode> parallelForStatement();
 	std::unique_ptr<ASTNode> whileStatement();
 	std::unique_ptr<ASTNode> breakStatement();
 	std::unique_ptr<ASTNode> continueStatement();
 	std::unique_ptr<ASTNode> functionCall(const Token& id);
 	std::unique_ptr<ASTNode> returnStatement();
 	std::unique_ptr<ASTNode> block();
+	std::vector<Token> skipBlock();
 	std::unique_ptr<ASTNode> expressionStatement();
 	std::unique_ptr<ASTNode> expression();
-	std::unique_ptr<ASTNode> assignment();
-	std::unique_ptr<ASTNode> logicalOr();
-	std::unique_ptr<ASTNode> logicalAnd();
-	std::unique_ptr<ASTNode> equality();
-	std::unique_ptr<ASTNode> comparison();
-	std::unique_ptr<ASTNode> term();
-	std::unique_ptr<ASTNode> factor();
-	std::unique_ptr<ASTNode> unary();
+	std::unique_ptr<ASTNode> postfix(std::unique_ptr<ASTNode> operand);
 	std::unique_ptr<ASTNode> primary();
+	std::unique_ptr<ASTNode> fieldAccess(std::unique_ptr<ASTNode> object);
 
 	// helper methods
 	void synchronize();
+	void recordError(const std::string& message);
 
-	bool isAtEnd() const {
+	Token fetch() {
+		if (lexer) {
+			return lexer->next();
+		}
+		if (pendingPos < pending.size()) {
+			return std::move(pending[pendingPos++]);
+		}
+		return Token(TokenType::EndOfFile, "", last.line, last.column);
+	}
+
+	// `Point p` starts a struct variable declaration
+	bool atStructVariable() {
+		return check(TokenType::Identifier) && peek(1).type == TokenType::Identifier;
+	}
+
+	bool isAtEnd() {
 		return peek().type == TokenType::EndOfFile;
 	}
 
-	Token peek() const {
-		return tokens[current];
+	const Token& peek(size_t offset = 0) {
+		if (offset >= LOOKAHEAD) {
+			throw std::runtime_error("parser lookahead exceeded");
+		}
+		while (buffered <= offset) {
+			lookahead[(head + buffered) % LOOKAHEAD] = fetch();
+			buffered++;
+		}
+		return lookahead[(head + offset) % LOOKAHEAD];
 	}
 
-	bool check(TokenType type) const {
+	bool check(TokenType type) {
 		if (isAtEnd()) return false;
 		return peek().type == type;
 	}
 
-	Token previous() const {
-		return tokens[current - 1];
+	const Token& previous() const {
+		return last;
 	}
 
-	Token advance() {
+	const Token& advance() {
 		if (!isAtEnd()) {
-			current++;
+			last = std::move(lookahead[head]);
+			head = (head + 1) % LOOKAHEAD;
+			buffered--;
 		}
 		return previous();
 	}
@@ -72,7 +123,7 @@ private:
 		return false;
 	}
 
-	Token consume(TokenType type, const std::string& message) {
+	const Token& consume(TokenType type, const std::string& message) {
 		if (check(type)) {
 			return advance();
 		}
@@ -84,6 +135,8 @@ private:
 		if (token.value == "double") return Type::DOUBLE;
 		if (token.value == "bool") return Type::BOOL;
 		if (token.value == "string") return Type::STRING;
+		if (token.value == "map") return Type::MAP;
+		if (token.value == "matrix") return Type::MATRIX;
 		if (token.value == "void") return Type::VOID;
 		throw std::runtime_error("unknown type keyword: " + token.value);
 	}
@@ -2,6 +2,7 @@
 #include <string>
 #include <unordered_set>
 #include <sstream>
+#include "../environment/Symbol.h"
 
 
 // token types for lexical analysis
@@ -20,20 +21,24 @@ enum class TokenType {
 	RightBrace,
 	Semicolon,
 	Comma,
+	Colon,
+	Dot, // p.x
 	EndOfFile
 };
 
 // represents a token in source code
 class Token {
 public:
-	Token(TokenType type, std::string value, int line, int column)
-		: type(type), value(value), line(line), column(column) {
+	Token() : Token(TokenType::EndOfFile, "", 0, 0) {}
+	Token(TokenType type, std::string value, int line, int column, SymbolId symbol = NO_SYMBOL)
+		: type(type), value(value), line(line), column(column), symbol(symbol) {
 	}
 
 	TokenType type;
 	std::string value;
 	size_t line;
 	size_t column;
+	SymbolId symbol; // interned name, identifiers only
 
 	std::string toString() const {
 		std::ostringstream oss;